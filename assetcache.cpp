@@ -0,0 +1,240 @@
+#include "assetcache.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+    #define ASSETCACHE_WIN32 1
+#elif defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define ASSETCACHE_MMAP 1
+#endif
+
+static const char CACHE_MAGIC[4] = { 'A', 'H', 'C', '1' };
+static const unsigned int CACHE_VERSION = 1;
+
+static unsigned long long alignUp(unsigned long long v) { return (v + 15) & ~15ull; }
+
+unsigned long long AssetHash(const unsigned char* data, long long size) {
+    unsigned long long h = 14695981039346656037ull;
+    for (long long i = 0; i < size; i++) { h ^= data[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+AssetCache::AssetCache(const char* cachePath)
+    : mapped(nullptr), mappedSize(0), mapHandle(nullptr), entries(nullptr), entryCount(0), entryUsed(nullptr),
+      pending(nullptr), pendingCount(0), pendingCapacity(0), hits(0), misses(0) {
+    size_t len = strlen(cachePath);
+    path = new char[len + 1];
+    memcpy(path, cachePath, len + 1);
+
+#if defined(ASSETCACHE_MMAP)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            mapped = (const unsigned char*)p;
+            mappedSize = (long long)st.st_size;
+        }
+    }
+    close(fd); // el mapeo sigue vivo sin el descriptor
+#elif defined(ASSETCACHE_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            void* p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (p) {
+                mapped = (const unsigned char*)p;
+                mappedSize = (long long)size.QuadPart;
+                mapHandle = mapping;
+            } else {
+                CloseHandle(mapping);
+            }
+        }
+    }
+    CloseHandle(file);
+#else
+    // Sin mmap (p. ej. web): se lee entero
+    FILE* f = fopen(path, "rb");
+    if (!f) return;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size > 0) {
+        unsigned char* data = new unsigned char[size];
+        if (fread(data, 1, (size_t)size, f) == (size_t)size) {
+            mapped = data;
+            mappedSize = size;
+        } else {
+            delete[] data;
+        }
+    }
+    fclose(f);
+#endif
+    if (mapped && !validate()) unmap();
+}
+
+AssetCache::~AssetCache() {
+    unmap();
+    for (int i = 0; i < pendingCount; i++) delete[] pending[i].pixels;
+    delete[] pending;
+    delete[] path;
+}
+
+void AssetCache::unmap() {
+    if (mapped) {
+#if defined(ASSETCACHE_MMAP)
+        munmap((void*)mapped, (size_t)mappedSize);
+#elif defined(ASSETCACHE_WIN32)
+        UnmapViewOfFile(mapped);
+        CloseHandle((HANDLE)mapHandle);
+#else
+        delete[] mapped;
+#endif
+    }
+    mapped = nullptr;
+    mappedSize = 0;
+    mapHandle = nullptr;
+    entries = nullptr;
+    entryCount = 0;
+    delete[] entryUsed;
+    entryUsed = nullptr;
+}
+
+bool AssetCache::validate() {
+    if (mappedSize < (long long)sizeof(CacheHeader)) return false;
+    CacheHeader header;
+    memcpy(&header, mapped, sizeof(header));
+    if (memcmp(header.magic, CACHE_MAGIC, 4) != 0 || header.version != CACHE_VERSION) return false;
+    unsigned long long tableEnd = sizeof(CacheHeader) + (unsigned long long)header.entryCount * sizeof(CacheEntry);
+    if (tableEnd > (unsigned long long)mappedSize) return false;
+
+    const CacheEntry* table = (const CacheEntry*)(mapped + sizeof(CacheHeader));
+    for (unsigned int i = 0; i < header.entryCount; i++) {
+        const CacheEntry& e = table[i];
+        if (e.size != (unsigned long long)e.width * e.height * 4) return false;
+        if (e.offset < tableEnd || e.offset + e.size > (unsigned long long)mappedSize) return false;
+    }
+    entries = table;
+    entryCount = (int)header.entryCount;
+    entryUsed = new unsigned char[entryCount > 0 ? entryCount : 1];
+    for (int i = 0; i < entryCount; i++) entryUsed[i] = 0;
+    return true;
+}
+
+const unsigned char* AssetCache::find(unsigned long long sourceHash, AssetMode mode, int& width, int& height) {
+    std::lock_guard<std::mutex> guard(lock);
+    for (int i = 0; i < entryCount; i++) {
+        const CacheEntry& e = entries[i];
+        if (e.sourceHash != sourceHash || e.mode != (unsigned int)mode) continue;
+        entryUsed[i] = 1;
+        width = (int)e.width;
+        height = (int)e.height;
+        hits++;
+        return mapped + e.offset;
+    }
+    misses++;
+    return nullptr;
+}
+
+void AssetCache::put(unsigned long long sourceHash, AssetMode mode, int width, int height, const unsigned char* rgba) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (pendingCount == pendingCapacity) {
+        int newCap = pendingCapacity > 0 ? pendingCapacity * 2 : 8;
+        PendingEntry* grown = new PendingEntry[newCap];
+        for (int i = 0; i < pendingCount; i++) grown[i] = pending[i];
+        delete[] pending;
+        pending = grown;
+        pendingCapacity = newCap;
+    }
+    PendingEntry& p = pending[pendingCount++];
+    memset(&p.entry, 0, sizeof(p.entry));
+    p.entry.sourceHash = sourceHash;
+    p.entry.mode = (unsigned int)mode;
+    p.entry.width = (unsigned int)width;
+    p.entry.height = (unsigned int)height;
+    p.entry.size = (unsigned long long)width * height * 4;
+    p.pixels = new unsigned char[p.entry.size];
+    memcpy(p.pixels, rgba, p.entry.size);
+}
+
+bool AssetCache::save() {
+    if (pendingCount == 0) {
+        unmap();
+        return true;
+    }
+    // Entradas que se conservan: las usadas en esta sesión y las nuevas. Lo que ya no se pide se descarta.
+    int kept = 0;
+    for (int i = 0; i < entryCount; i++) kept += entryUsed[i];
+    int total = kept + pendingCount;
+    CacheEntry* table = new CacheEntry[total];
+    const unsigned char** data = new const unsigned char*[total];
+    unsigned long long offset = alignUp(sizeof(CacheHeader) + (unsigned long long)total * sizeof(CacheEntry));
+    int n = 0;
+    for (int i = 0; i < entryCount; i++) {
+        if (!entryUsed[i]) continue;
+        table[n] = entries[i];
+        data[n++] = mapped + entries[i].offset;
+    }
+    for (int i = 0; i < pendingCount; i++) {
+        table[n] = pending[i].entry;
+        data[n++] = pending[i].pixels;
+    }
+    for (int i = 0; i < total; i++) {
+        table[i].offset = offset;
+        offset = alignUp(offset + table[i].size);
+    }
+
+    // Se escribe a un temporal y se renombra: un arranque a medias nunca ve un fichero cortado
+    size_t len = strlen(path);
+    char* tmpPath = new char[len + 5];
+    memcpy(tmpPath, path, len);
+    memcpy(tmpPath + len, ".tmp", 5);
+    bool ok = false;
+    FILE* f = fopen(tmpPath, "wb");
+    if (f) {
+        CacheHeader header;
+        memcpy(header.magic, CACHE_MAGIC, 4);
+        header.version = CACHE_VERSION;
+        header.entryCount = (unsigned int)total;
+        header.reserved = 0;
+        ok = fwrite(&header, sizeof(header), 1, f) == 1;
+        ok = ok && fwrite(table, sizeof(CacheEntry), (size_t)total, f) == (size_t)total;
+        static const unsigned char padding[16] = { 0 };
+        long long written = (long long)(sizeof(header) + (size_t)total * sizeof(CacheEntry));
+        for (int i = 0; i < total && ok; i++) {
+            ok = fwrite(padding, 1, (size_t)(table[i].offset - written), f) == (size_t)(table[i].offset - written);
+            ok = ok && fwrite(data[i], 1, (size_t)table[i].size, f) == (size_t)table[i].size;
+            written = (long long)(table[i].offset + table[i].size);
+        }
+        ok = (fclose(f) == 0) && ok;
+    }
+    delete[] table;
+    delete[] data;
+
+    // Las entradas conservadas apuntaban al mapeo: solo ahora se puede soltar
+    unmap();
+    for (int i = 0; i < pendingCount; i++) delete[] pending[i].pixels;
+    pendingCount = 0;
+    if (ok) {
+#if defined(ASSETCACHE_WIN32)
+        ok = MoveFileExA(tmpPath, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        ok = rename(tmpPath, path) == 0;
+#endif
+    }
+    if (!ok) remove(tmpPath);
+    delete[] tmpPath;
+    return ok;
+}
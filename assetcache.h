@@ -0,0 +1,77 @@
+#ifndef ASSETCACHE_H
+#define ASSETCACHE_H
+
+// Caché de recursos ya procesados: píxeles RGBA8 limpios, indexados por el hash del fichero
+// fuente y el modo de limpieza. Al arrancar se mapea en memoria y las texturas se crean
+// directamente desde el mapeo; si el fuente cambió, su hash ya no coincide y se vuelve a
+// decodificar (y a guardar).
+//
+// Formato (little endian): CacheHeader, CacheEntry[entryCount] y los píxeles de cada entrada
+// alineados a 16 bytes.
+
+#include <mutex>
+
+enum AssetMode { ASSET_PLAIN = 0, ASSET_SPRITE = 1, ASSET_EXPLOSION = 2 };
+
+// FNV-1a de 64 bits sobre los bytes del fichero fuente
+unsigned long long AssetHash(const unsigned char* data, long long size);
+
+class AssetCache {
+private:
+    struct CacheHeader {
+        char magic[4];
+        unsigned int version;
+        unsigned int entryCount;
+        unsigned int reserved;
+    };
+    struct CacheEntry {
+        unsigned long long sourceHash;
+        unsigned int mode;
+        unsigned int width, height;
+        unsigned int reserved;
+        unsigned long long offset; // desde el principio del fichero
+        unsigned long long size;
+    };
+    // Entrada nueva de esta sesión: los píxeles se copian hasta save()
+    struct PendingEntry {
+        CacheEntry entry;
+        unsigned char* pixels;
+    };
+
+    char* path;
+    // Mapeo del fichero (o copia en memoria donde no hay mmap)
+    const unsigned char* mapped;
+    long long mappedSize;
+    void* mapHandle;
+    const CacheEntry* entries;
+    int entryCount;
+    unsigned char* entryUsed;
+    PendingEntry* pending;
+    int pendingCount, pendingCapacity;
+    int hits, misses;
+    std::mutex lock; // find y put se llaman desde los hilos del cargador
+
+    void unmap();
+    bool validate();
+
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+public:
+    // Abre y valida la caché; si no existe o está corrupta empieza vacía
+    explicit AssetCache(const char* cachePath);
+    ~AssetCache();
+
+    // Píxeles RGBA8 de la entrada, o nullptr si no está. El puntero vale hasta save() o el destructor.
+    // find y put se pueden llamar desde varios hilos a la vez; save no.
+    const unsigned char* find(unsigned long long sourceHash, AssetMode mode, int& width, int& height);
+    // Registra el resultado del camino lento para guardarlo en save()
+    void put(unsigned long long sourceHash, AssetMode mode, int width, int height, const unsigned char* rgba);
+    // Si hubo entradas nuevas, reescribe el fichero con ellas y con las que se usaron en esta sesión.
+    // Deshace el mapeo. Devuelve false si no se pudo escribir.
+    bool save();
+
+    int hitCount() const { return hits; }
+    int missCount() const { return misses; }
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "assetloader.h"
+#include "spriteclean.h"
+
+Image LoadCleanImage(AssetCache& cache, const char* path, AssetMode mode, bool& owned, JobSystem* jobs) {
+    Image image = {};
+    owned = false;
+    int size = 0;
+    unsigned char* file = LoadFileData(path, &size);
+    if (!file) return image;
+    unsigned long long hash = AssetHash(file, size);
+
+    int width = 0, height = 0;
+    const unsigned char* pixels = cache.find(hash, mode, width, height);
+    if (pixels) {
+        image.data = (void*)pixels;
+        image.width = width;
+        image.height = height;
+        image.mipmaps = 1;
+        image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    } else {
+        image = LoadImageFromMemory(GetFileExtension(path), file, size);
+        if (image.data) {
+            ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+            if (mode != ASSET_PLAIN) {
+                CleanSpritePixels((unsigned char*)image.data, image.width * image.height, mode == ASSET_EXPLOSION, jobs);
+            }
+            cache.put(hash, mode, image.width, image.height, (const unsigned char*)image.data);
+            owned = true;
+        }
+    }
+    UnloadFileData(file);
+    return image;
+}
+
+AssetLoader::AssetLoader(AssetCache& cache, int capacity)
+    : cache(cache), itemCount(0), itemCapacity(capacity), workers(nullptr), workerCount(0),
+      nextItem(0), loadedItems(0), quit(false) {
+    items = new Item[capacity];
+}
+
+AssetLoader::~AssetLoader() {
+    quit.store(true);
+    for (int i = 0; i < workerCount; i++) workers[i].join();
+    delete[] workers;
+    for (int i = 0; i < itemCount; i++) {
+        if (items[i].state.load() == ITEM_LOADED) freeItem(items[i]);
+    }
+    delete[] items;
+}
+
+int AssetLoader::add(const char* path, AssetKind kind, AssetMode mode) {
+    if (itemCount == itemCapacity) return -1;
+    Item& item = items[itemCount];
+    item.path = path;
+    item.kind = kind;
+    item.mode = mode;
+    item.image = {};
+    item.ownsImage = false;
+    item.wave = {};
+    item.fileData = nullptr;
+    item.fileSize = 0;
+    item.state.store(ITEM_QUEUED);
+    return itemCount++;
+}
+
+void AssetLoader::start(int threads) {
+    if (threads > itemCount) threads = itemCount;
+    if (threads <= 0) return;
+    workerCount = threads;
+    workers = new std::thread[threads];
+    for (int i = 0; i < threads; i++) {
+        workers[i] = std::thread([this] {
+            while (!quit.load(std::memory_order_relaxed) && loadNext()) {}
+        });
+    }
+}
+
+void AssetLoader::update() {
+    if (workerCount == 0) loadNext();
+}
+
+bool AssetLoader::loadNext() {
+    int index = nextItem.fetch_add(1);
+    if (index >= itemCount) return false;
+    loadItem(items[index]);
+    // release: el hilo principal ve los datos completos en cuanto ve ITEM_LOADED
+    items[index].state.store(ITEM_LOADED, std::memory_order_release);
+    loadedItems.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+void AssetLoader::loadItem(Item& item) {
+    switch (item.kind) {
+        case ASSET_KIND_IMAGE:
+            // Ya se cargan varios recursos a la vez: cada limpieza va en un solo hilo
+            item.image = LoadCleanImage(cache, item.path, item.mode, item.ownsImage, nullptr);
+            break;
+        case ASSET_KIND_WAVE:
+            item.wave = LoadWave(item.path);
+            break;
+        case ASSET_KIND_FILE:
+            item.fileData = LoadFileData(item.path, &item.fileSize);
+            break;
+    }
+}
+
+void AssetLoader::freeItem(Item& item) {
+    if (item.ownsImage) UnloadImage(item.image);
+    if (item.wave.data) UnloadWave(item.wave);
+    if (item.fileData) UnloadFileData(item.fileData);
+    item.image = {};
+    item.ownsImage = false;
+    item.wave = {};
+    item.fileData = nullptr;
+}
+
+unsigned char* AssetLoader::takeFile(int id, int& size) {
+    unsigned char* data = items[id].fileData;
+    size = items[id].fileSize;
+    items[id].fileData = nullptr;
+    return data;
+}
+
+void AssetLoader::release(int id) {
+    if (items[id].state.load(std::memory_order_acquire) != ITEM_LOADED) return;
+    freeItem(items[id]);
+    items[id].state.store(ITEM_RELEASED, std::memory_order_relaxed);
+}
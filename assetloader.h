@@ -0,0 +1,80 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include "raylib.h"
+#include "assetcache.h"
+
+#include <atomic>
+#include <thread>
+
+class JobSystem;
+
+// Imagen RGBA8 ya limpia. Con la caché caliente los píxeles apuntan al mapeo (owned = false, no
+// se descargan) y no se decodifica ni se limpia nada; si no, camino lento y se guarda en la caché.
+// La limpieza se reparte entre los hilos de 'jobs' (nullptr = hilo actual).
+Image LoadCleanImage(AssetCache& cache, const char* path, AssetMode mode, bool& owned, JobSystem* jobs);
+
+enum AssetKind {
+    ASSET_KIND_IMAGE, // decodifica y limpia (ver LoadCleanImage)
+    ASSET_KIND_WAVE,  // decodifica el audio entero
+    ASSET_KIND_FILE   // solo lee el fichero (música en streaming)
+};
+
+// Carga de recursos en segundo plano. Los hilos del cargador hacen la parte de CPU (leer,
+// decodificar, limpiar) y el hilo principal, frame a frame, sube a la GPU o al dispositivo de
+// audio lo que ya esté cargado y lo suelta con release(). Nada de raylib que toque OpenGL o
+// el audio se llama fuera del hilo principal.
+class AssetLoader {
+private:
+    enum { ITEM_QUEUED, ITEM_LOADED, ITEM_RELEASED };
+    struct Item {
+        const char* path;
+        AssetKind kind;
+        AssetMode mode;
+        Image image;
+        bool ownsImage;
+        Wave wave;
+        unsigned char* fileData;
+        int fileSize;
+        std::atomic<int> state;
+    };
+
+    AssetCache& cache;
+    Item* items;
+    int itemCount, itemCapacity;
+    std::thread* workers;
+    int workerCount;
+    std::atomic<int> nextItem;
+    std::atomic<int> loadedItems;
+    std::atomic<bool> quit;
+
+    bool loadNext();
+    void loadItem(Item& item);
+    void freeItem(Item& item);
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+public:
+    AssetLoader(AssetCache& cache, int capacity);
+    // Espera a que los hilos terminen el recurso que tengan entre manos
+    ~AssetLoader();
+
+    // Devuelve el id del recurso; solo antes de start()
+    int add(const char* path, AssetKind kind, AssetMode mode = ASSET_PLAIN);
+    // Lanza 'threads' hilos. Con 0 (web, sin pthreads) cada update() carga un recurso en el hilo actual.
+    void start(int threads);
+    void update();
+
+    bool isLoaded(int id) const { return items[id].state.load(std::memory_order_acquire) == ITEM_LOADED; }
+    const Image& image(int id) const { return items[id].image; }
+    const Wave& wave(int id) const { return items[id].wave; }
+    // Pasa la propiedad del fichero leído al que llama (se libera con UnloadFileData)
+    unsigned char* takeFile(int id, int& size);
+    // Libera la copia en CPU una vez subida
+    void release(int id);
+
+    int count() const { return itemCount; }
+    int loadedCount() const { return loadedItems.load(std::memory_order_acquire); }
+};
+
+#endif
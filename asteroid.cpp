@@ -1,216 +1,234 @@
 #include "raylib.h"
-#include "quadtree.h"
+#include "simulation.h"
+#include "session.h"
+#include "profiler.h"
+#include "spritebatch.h"
+#include "assetloader.h"
 
 #include "raymath.h"
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
 #if defined(PLATFORM_WEB)
     #include <emscripten/emscripten.h>
 #endif
 
-    enum GameState { GAME_MENU, GAME_PLAYING, GAME_PAUSED, GAME_OVER };
-    GameState currentGameState = GAME_MENU;
-
     bool playWithBot = true;
-    bool playerWon = false;
+    int duoBots = 1; // bots en el modo duo (--bots N para probar con un enjambre)
     int SCREEN_WIDTH = 1280;
     int SCREEN_HEIGHT = 720;
-
-    const int MAX_ASTEROIDS = 2000;
-    const int MAX_BULLETS = 60;
-    const int MAX_EXPLOSIONS = 25;
-    const int WIN_SCORE = 2500;
-
-    struct EntityData {
-        Vector2 velocity;
-        int size;
-        bool active;
-        int id;
-    };
-
-    struct Explosion {
-        Vector2 position;
-        int currentFrame;
-        int frameCounter;
-        float scale;
-        bool active; };
-
-    struct BotPlayer {
-        GameObject entity;
-        Vector2 velocity;
-        float rotation;
-        bool active;
-        float fireTimer;
-        int score;
-        float wanderTimer;
-        float aimError;
-    };
-
-    GameObject asteroids[MAX_ASTEROIDS];
-    EntityData astData[MAX_ASTEROIDS];
-    GameObject bullets[MAX_BULLETS];
-    EntityData bulData[MAX_BULLETS];
-    Explosion explosions[MAX_EXPLOSIONS];
-    int globalIdCounter = 0;
-    int playerScore = 0;
-    GameObject ship;
-    Vector2 shipVel = { 0, 0 };
-    float visualRotation = 0;
-    int lives = 3;
-    float spawnTimer = 0;
-    BotPlayer bot;
-
-
-    Texture2D background, shipTex, asteroidTex, explosionTex;
+    // --world N: mundo de NxN pantallas en sectores de una pantalla, con la cámara sobre la nave
+    int worldScreens = 1;
+
+    // Estado del juego (asteroides, balas, nave, bot y broadphase). Se crea en main
+    // con el broadphase elegido (--broadphase loose|quadtree|grid).
+    GameSim* sim = nullptr;
+    // Estados del juego fuera del menú y reloj de paso fijo (--tick-rate, 60 por defecto)
+    GameSession* session = nullptr;
+    // Cada partida se graba y se guarda al volver al menú o al cerrar (--record para otra ruta).
+    // --replay la repite sin ventana.
+    Replay replay;
+    const char* replayPath = "last_game.replay";
+
+
+    Texture2D background, shipTex, asteroidTex, explosionTex, bulletAtlas;
+
+    // Un lote por textura; los buffers se reutilizan de un frame a otro
+    SpriteBatch shipBatch, asteroidBatch, explosionBatch, bulletBatch;
+    // Partículas: fogonazos con el flipbook de la explosión, escombros con la textura del
+    // asteroide y chispas con el círculo del atlas de balas
+    SpriteBatch debrisBatch, sparkBatch;
+    const int EXPLOSION_FRAMES = 6;
+    Rectangle explosionFrames[EXPLOSION_FRAMES];
+    // Atlas de balas: una celda de 10x10 por color (jugador, bot)
+    const float BULLET_CELL = 10.0f;
+    const Rectangle BULLET_PLAYER_SRC = { 0, 0, BULLET_CELL, BULLET_CELL };
+    const Rectangle BULLET_BOT_SRC = { BULLET_CELL, 0, BULLET_CELL, BULLET_CELL };
     Sound fxShot, fxExplosion;
     Music music;
+    unsigned char* musicData = nullptr; // LoadMusicStreamFromMemory lo necesita vivo mientras suena
+    // Centro de la pantalla en el mundo y asteroides que se ven desde ahí (índices densos)
+    Vector2 camera = { 0, 0 };
+    int* visibleAsteroids = nullptr;
 
 
-    void SplitAsteroid(int index, bool hitByPlayer) {
-        int currentSize = astData[index].size;
-        Point pos = asteroids[index].position;
-        astData[index].active = false;
-
-        if (hitByPlayer) playerScore += 100;
-        else bot.score += 100;
-
-        if (currentSize > 1) {
-            int created = 0;
-            for (int i = 0; i < MAX_ASTEROIDS && created < 2; i++) {
-                if (!astData[i].active) {
-                    astData[i].active = true;
-                    astData[i].size = currentSize - 1;
-                    astData[i].id = globalIdCounter++;
-                    asteroids[i].position = pos;
-                    asteroids[i].width = (float)astData[i].size * 30.0f;
-                    asteroids[i].height = (float)astData[i].size * 30.0f;
-                    asteroids[i].type = 2;
-                    asteroids[i].id = astData[i].id;
-                    float angle = (float)GetRandomValue(0, 360) * DEG2RAD;
-                    astData[i].velocity = { cosf(angle) * 2.5f, sinf(angle) * 2.5f };
-                    created++;
-                }
-            }
-        }
-    }
-
+    // La semilla sale de raylib una vez por partida; a partir de ahí la simulación es determinista
     void ResetGame() {
-        playerScore = 0; bot.score = 0; lives = 3; playerWon = false;
-        ship.position = { (float)SCREEN_WIDTH / 3, (float)SCREEN_HEIGHT / 2 };
-        shipVel = { 0, 0 }; spawnTimer = 3.0f;
-        bot.entity.position = { (float)SCREEN_WIDTH * 0.7f, (float)SCREEN_HEIGHT / 2 };
-        bot.velocity = { 0, 0 }; bot.active = playWithBot; bot.rotation = 0;
-        bot.wanderTimer = 0; bot.aimError = 0;
-
-        for (int i = 0; i < MAX_ASTEROIDS; i++) astData[i].active = false;
-        for (int i = 0; i < MAX_BULLETS; i++) bulData[i].active = false;
-        for (int i = 0; i < MAX_EXPLOSIONS; i++) explosions[i].active = false;
-
-        for (int i = 0; i < 15; i++) {
-            astData[i].active = true; astData[i].size = 3; astData[i].id = globalIdCounter++;
-            asteroids[i].position = {(float)GetRandomValue(0, SCREEN_WIDTH), (float)GetRandomValue(0, SCREEN_HEIGHT)};
-            asteroids[i].width = 60; asteroids[i].height = 60; asteroids[i].type = 2;
-            asteroids[i].id = astData[i].id;
-            astData[i].velocity = {(float)GetRandomValue(-200, 200)/100.0f, (float)GetRandomValue(-200, 200)/100.0f};
-        }
+        session->start((unsigned int)GetRandomValue(1, 0x7FFFFFFF), playWithBot ? duoBots : 0,
+                       INITIAL_ASTEROIDS * worldScreens * worldScreens);
     }
 
-void SuperCleanSprite(Image *image, bool isExplosion)
-    {
-        if (!image || !image->data) return;
-
-        ImageFormat(image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
-        Color *p = (Color *)image->data;
-
-        for (int i = 0; i < image->width * image->height; i++)
-        {
-            if (isExplosion)
-            {
-                int br = (p[i].r + p[i].g + p[i].b) / 3;
-
-                const int cutoff = 35;
-                const float gain = 3.0f;
-
-                int a = (int)((br - cutoff) * gain);
-                if (a < 0) a = 0;
-                if (a > 255) a = 255;
+    void SaveReplay() {
+        if (replay.frames() == 0) return;
+        long long bytes = 0;
+        if (replay.save(replayPath, &bytes)) TraceLog(LOG_INFO, "Partida grabada en %s (%i frames, %lld bytes)", replayPath, replay.frames(), bytes);
+        else TraceLog(LOG_WARNING, "No se pudo escribir %s", replayPath);
+        replay.begin(replay.header);
+    }
 
-                p[i].a = (unsigned char)a;
+    // Posición de dibujo entre el tick anterior y el actual. Lo que dio la vuelta a la pantalla
+    // salta directamente: interpolar cruzaría el mundo entero.
+    float LerpTick(float prev, float cur, float alpha, float span) {
+        if (fabsf(cur - prev) > span * 0.5f) return cur;
+        return prev + (cur - prev) * alpha;
+    }
 
+    Vector2 TickPosition(float prevX, float prevY, float x, float y, float alpha) {
+        return { LerpTick(prevX, x, alpha, sim->width), LerpTick(prevY, y, alpha, sim->height) };
+    }
 
-                if (p[i].a == 0) p[i] = (Color){0,0,0,0};
-            }
-            else
-            {
-                if (p[i].r > 210 && p[i].g > 210 && p[i].b > 210) p[i] = BLANK;
-            }
-        }
+    // Distancia más corta por el mundo envuelto
+    float WrapDelta(float d, float span) {
+        if (d > span * 0.5f) return d - span;
+        if (d < -span * 0.5f) return d + span;
+        return d;
     }
 
+    // Del mundo a la pantalla con la cámara en el centro. Con el mundo del tamaño de la pantalla
+    // y la cámara en su centro deja las posiciones como están.
+    Vector2 ViewPosition(float prevX, float prevY, float x, float y, float alpha) {
+        Vector2 p = TickPosition(prevX, prevY, x, y, alpha);
+        return { WrapDelta(p.x - camera.x, sim->width) + SCREEN_WIDTH * 0.5f,
+                 WrapDelta(p.y - camera.y, sim->height) + SCREEN_HEIGHT * 0.5f };
+    }
 
-    void UpdateBotAI(BotPlayer &b, GameObject asts[], EntityData data[], Sound shotSound) {
-        if (!b.active) return;
+    const char* ASSET_CACHE_PATH = "resources/assets.cache";
+
+    // Recursos que carga AssetLoader; el id de cada uno es su posición en la tabla
+    enum { LOAD_BACKGROUND, LOAD_SHIP, LOAD_ASTEROID, LOAD_EXPLOSION, LOAD_SHOT, LOAD_BOOM, LOAD_MUSIC, LOAD_COUNT };
+    struct AssetSource { const char* path; AssetKind kind; AssetMode mode; };
+    const AssetSource GAME_ASSETS[LOAD_COUNT] = {
+        { "resources/space_bg3.png", ASSET_KIND_IMAGE, ASSET_PLAIN },
+        { "resources/ship0.png", ASSET_KIND_IMAGE, ASSET_SPRITE },
+        { "resources/asteroid0.png", ASSET_KIND_IMAGE, ASSET_SPRITE },
+        { "resources/explosion7.png", ASSET_KIND_IMAGE, ASSET_EXPLOSION },
+        { "resources/shot.wav", ASSET_KIND_WAVE, ASSET_PLAIN },
+        { "resources/explosion.wav", ASSET_KIND_WAVE, ASSET_PLAIN },
+        { "resources/music1.mp3", ASSET_KIND_FILE, ASSET_PLAIN },
+    };
 
-        float closestDist = 2000.0f;
-        int targetIdx = -1;
+    // Carga en segundo plano: el menú se dibuja mientras tanto y no se puede jugar hasta que todo está subido
+    AssetCache* assetCache = nullptr;
+    AssetLoader* assetLoader = nullptr;
+    int assetsUploaded = 0;
+    bool assetsReady = false;
+    bool firstFrameShown = false;
+    std::chrono::steady_clock::time_point startTime;
 
+    double ElapsedMs(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    }
 
-        for (int i = 0; i < MAX_ASTEROIDS; i++) {
-            if (data[i].active) {
-                float d = Vector2Distance({b.entity.position.x, b.entity.position.y}, {asts[i].position.x, asts[i].position.y});
-                if (d < closestDist) { closestDist = d; targetIdx = i; }
+    // Sube en el hilo principal lo que los hilos del cargador ya dejaron listo
+    void UploadLoadedAssets()
+    {
+        if (assetsReady) return;
+        assetLoader->update();
+        for (int i = 0; i < LOAD_COUNT; i++) {
+            if (!assetLoader->isLoaded(i)) continue;
+            switch (i) {
+                case LOAD_BACKGROUND: background = LoadTextureFromImage(assetLoader->image(i)); break;
+                case LOAD_SHIP: shipTex = LoadTextureFromImage(assetLoader->image(i)); break;
+                case LOAD_ASTEROID: asteroidTex = LoadTextureFromImage(assetLoader->image(i)); break;
+                case LOAD_EXPLOSION:
+                    explosionTex = LoadTextureFromImage(assetLoader->image(i));
+                    SetTextureFilter(explosionTex, TEXTURE_FILTER_POINT);
+                    // Los rectángulos de cada frame de la tira se calculan una vez
+                    for (int f = 0; f < EXPLOSION_FRAMES; f++) {
+                        float frameWidth = (float)(explosionTex.width / EXPLOSION_FRAMES);
+                        explosionFrames[f] = { f * frameWidth, 0.0f, frameWidth, (float)explosionTex.height };
+                    }
+                    break;
+                case LOAD_SHOT:
+                    fxShot = LoadSoundFromWave(assetLoader->wave(i));
+                    SetSoundVolume(fxShot, 0.5f);
+                    break;
+                case LOAD_BOOM:
+                    fxExplosion = LoadSoundFromWave(assetLoader->wave(i));
+                    SetSoundVolume(fxExplosion, 0.5f);
+                    break;
+                case LOAD_MUSIC: {
+                    int size = 0;
+                    musicData = assetLoader->takeFile(i, size);
+                    if (musicData) music = LoadMusicStreamFromMemory(GetFileExtension(GAME_ASSETS[i].path), musicData, size);
+                    SetMusicVolume(music, 0.4f);
+                    break;
+                }
             }
+            assetLoader->release(i);
+            assetsUploaded++;
         }
+        if (assetsUploaded < LOAD_COUNT) return;
+
+        assetsReady = true;
+        TraceLog(LOG_INFO, "Recursos listos a los %.2f ms, caché %s (%d aciertos, %d fallos)", ElapsedMs(startTime),
+                 assetCache->missCount() == 0 ? "caliente" : "fría", assetCache->hitCount(), assetCache->missCount());
+        // Las texturas ya están en la GPU: se puede soltar el mapeo
+        delete assetLoader;
+        assetLoader = nullptr;
+        if (!assetCache->save()) TraceLog(LOG_WARNING, "No se pudo escribir %s", ASSET_CACHE_PATH);
+        delete assetCache;
+        assetCache = nullptr;
+    }
 
-        b.wanderTimer -= GetFrameTime();
-
-        if (targetIdx != -1 && b.wanderTimer <= 0) {
-           
-            if (GetRandomValue(0, 100) < 5) b.aimError = (float)GetRandomValue(-15, 15); // Cambia el error de vez en cuando
-
-            float angleToTarget = atan2f(asts[targetIdx].position.y - b.entity.position.y, asts[targetIdx].position.x - b.entity.position.x) * RAD2DEG;
-            float diff = (angleToTarget + b.aimError) - b.rotation;
-
-            while (diff > 180) diff -= 360;
-            while (diff < -180) diff += 360;
-            b.rotation += diff * 0.05f;
-
-            b.velocity.x += cosf(b.rotation * DEG2RAD) * 0.15f;
-            b.velocity.y += sinf(b.rotation * DEG2RAD) * 0.15f;
-
-
-            b.fireTimer += GetFrameTime();
-            if (b.fireTimer > 0.6f && closestDist < 600) {
-                if (GetRandomValue(0, 10) > 2) {
-                    for (int i = 0; i < MAX_BULLETS; i++) if (!bulData[i].active) {
-                        bulData[i].active = true; bullets[i].position = b.entity.position;
-                        bullets[i].width = 10; bullets[i].height = 10; bullets[i].type = 4;
-                        bulData[i].velocity = { cosf(b.rotation * DEG2RAD) * 11.0f, sinf(b.rotation * DEG2RAD) * 11.0f };
-                        b.fireTimer = 0;
-                        PlaySound(shotSound);
-                        break;
-                    }
-                } else {
-                    b.fireTimer = 0.3f;
+    // --bake-assets: rellena la caché sin abrir ventana. Se ejecuta dos veces para medir frío y caliente.
+    int BakeAssets()
+    {
+        remove(ASSET_CACHE_PATH);
+        for (int pass = 0; pass < 2; pass++) {
+            auto t0 = std::chrono::steady_clock::now();
+            AssetCache cache(ASSET_CACHE_PATH);
+            for (int i = 0; i < LOAD_COUNT; i++) {
+                if (GAME_ASSETS[i].kind != ASSET_KIND_IMAGE) continue;
+                bool owned = false;
+                Image image = LoadCleanImage(cache, GAME_ASSETS[i].path, GAME_ASSETS[i].mode, owned, sim->jobSystem());
+                if (!image.data) {
+                    fprintf(stderr, "no se pudo cargar %s\n", GAME_ASSETS[i].path);
+                    return 1;
                 }
+                if (owned) UnloadImage(image);
             }
-        } else {
-
-            if (b.wanderTimer <= -1.5f) {
-                b.wanderTimer = (float)GetRandomValue(1, 3);
-                b.velocity.x += (float)GetRandomValue(-5, 5);
-                b.velocity.y += (float)GetRandomValue(-5, 5);
+            double loadMs = ElapsedMs(t0);
+            if (!cache.save()) {
+                fprintf(stderr, "no se pudo escribir %s\n", ASSET_CACHE_PATH);
+                return 1;
             }
-            b.rotation += 2.0f;
+            printf("%s: %.2f ms de carga, %.2f ms con escritura (%d aciertos, %d fallos)\n",
+                   pass == 0 ? "frío" : "caliente", loadMs, ElapsedMs(t0), cache.hitCount(), cache.missCount());
         }
+        return 0;
+    }
 
 
-        b.entity.position.x += b.velocity.x; b.entity.position.y += b.velocity.y;
-        b.velocity.x *= 0.96f; b.velocity.y *= 0.96f;
 
+#if defined(ASTEROID_PROFILER)
+    // Overlay del perfilador (F3) y volcado a CSV (F4). Los percentiles se recalculan cada 30 frames.
+    bool showProfiler = false;
+    ProfileSummary profileSummary = {};
 
-        if (b.entity.position.x > SCREEN_WIDTH) b.entity.position.x = 0; else if (b.entity.position.x < 0) b.entity.position.x = SCREEN_WIDTH;
-        if (b.entity.position.y > SCREEN_HEIGHT) b.entity.position.y = 0; else if (b.entity.position.y < 0) b.entity.position.y = SCREEN_HEIGHT;
+    void DrawProfilerOverlay() {
+        if (GlobalProfiler().frameCount() % 30 == 0) GlobalProfiler().summarize(profileSummary);
+        int x = SCREEN_WIDTH - 360, y = 20;
+        DrawRectangle(x - 10, y - 10, 350, 30 + 18 * (PROFILE_PHASE_COUNT + PROFILE_COUNTER_COUNT + 2), Fade(BLACK, 0.7f));
+        DrawText(TextFormat("%-11s  p50     p95     p99 (ms, %i frames)", "fase", profileSummary.frames), x, y, 14, YELLOW);
+        y += 20;
+        for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+            DrawText(TextFormat("%-11s %6.3f  %6.3f  %6.3f", Profiler::phaseName(p),
+                                profileSummary.p50[p], profileSummary.p95[p], profileSummary.p99[p]), x, y, 14, RAYWHITE);
+            y += 18;
+        }
+        y += 8;
+        for (int c = 0; c < PROFILE_COUNTER_COUNT; c++) {
+            DrawText(TextFormat("%-11s %lld", Profiler::counterName(c), profileSummary.last[c]), x, y, 14, SKYBLUE);
+            y += 18;
+        }
+        DrawText("F3 ocultar - F4 guardar profile.csv", x, y + 4, 12, LIGHTGRAY);
     }
+#endif
 
 static inline int Dist2(Color a, Color b)
     {
@@ -221,255 +239,228 @@ static inline int Dist2(Color a, Color b)
     }
 
 void UpdateDrawFrame(void) {
-        
-        if (IsMusicStreamPlaying(music)) {
-            UpdateMusicStream(music);
-        }
-        
-        else if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) || GetKeyPressed() > 0) {
-            PlayMusicStream(music);
-        }
-        switch (currentGameState) {
-                case GAME_MENU:
-                    if (IsKeyPressed(KEY_UP) || IsKeyPressed(KEY_DOWN)) playWithBot = !playWithBot;
-                    if (IsKeyPressed(KEY_ENTER)) { ResetGame(); currentGameState = GAME_PLAYING; }
-                    break;
-
-                case GAME_PLAYING:
-                {
-                    // --- ERROR 1 CORREGIDO: CAPTURAR ESCAPE AQUÍ ---
-                    if (IsKeyPressed(KEY_ESCAPE)) {
-                        currentGameState = GAME_PAUSED;
-                        break; // Salimos del switch para que no procese el frame de juego
-                    }
-                    if (lives <= 0) { playerWon = false; currentGameState = GAME_OVER; }
-                    if (playerScore >= WIN_SCORE) { playerWon = true; currentGameState = GAME_OVER; }
-                    if (playWithBot && bot.score >= WIN_SCORE) { playerWon = false; currentGameState = GAME_OVER; }
-
-                    float dt = GetFrameTime();
-                    if (spawnTimer > 0) spawnTimer -= dt;
-
-                    if (IsKeyDown(KEY_W)) shipVel.y -= 0.6f;
-                    if (IsKeyDown(KEY_S)) shipVel.y += 0.6f;
-                    if (IsKeyDown(KEY_A)) shipVel.x -= 0.6f;
-                    if (IsKeyDown(KEY_D)) shipVel.x += 0.6f;
-
-                    shipVel.x *= 0.94f; shipVel.y *= 0.94f;
-                    if (Vector2Length(shipVel) > 0.1f) visualRotation = atan2f(shipVel.y, shipVel.x) * RAD2DEG;
-                    ship.position.x += shipVel.x; ship.position.y += shipVel.y;
-
-                    if (ship.position.x > SCREEN_WIDTH) ship.position.x = 0; else if (ship.position.x < 0) ship.position.x = SCREEN_WIDTH;
-                    if (ship.position.y > SCREEN_HEIGHT) ship.position.y = 0; else if (ship.position.y < 0) ship.position.y = SCREEN_HEIGHT;
-
-                    if (IsKeyPressed(KEY_Q)) {
-                        for (int i = 0; i < MAX_BULLETS; i++) {
-                            if (!bulData[i].active) {
-                                bulData[i].active = true;
-                                bullets[i].position = ship.position;
-                                bullets[i].type = 3; // Tipo jugador
-                                
-                                bulData[i].velocity = {
-                                    cosf(visualRotation * DEG2RAD) * 12.0f,
-                                    sinf(visualRotation * DEG2RAD) * 12.0f
-                                };
-                                
-                                PlaySound(fxShot);
-                                break; 
-                            }
-                        }
-                    }
-
-                    if(bot.active) UpdateBotAI(bot, asteroids, astData, fxShot);
-
-                    QuadTree qt(CustomRectangle(SCREEN_WIDTH/2, SCREEN_HEIGHT/2, SCREEN_WIDTH, SCREEN_HEIGHT));
-                    qt.insert(ship); if(bot.active) qt.insert(bot.entity);
-
-                    for (int i = 0; i < MAX_ASTEROIDS; i++) if (astData[i].active) {
-                        asteroids[i].position.x += astData[i].velocity.x; asteroids[i].position.y += astData[i].velocity.y;
-                        if (asteroids[i].position.x > SCREEN_WIDTH) asteroids[i].position.x = 0; else if (asteroids[i].position.x < 0) asteroids[i].position.x = SCREEN_WIDTH;
-                        if (asteroids[i].position.y > SCREEN_HEIGHT) asteroids[i].position.y = 0; else if (asteroids[i].position.y < 0) asteroids[i].position.y = SCREEN_HEIGHT;
-                        qt.insert(asteroids[i]);
-                    }
+        PROFILE_BEGIN(PROFILE_FRAME);
+#if defined(ASTEROID_PROFILER)
+        if (IsKeyPressed(KEY_F3)) showProfiler = !showProfiler;
+        if (IsKeyPressed(KEY_F4) && GlobalProfiler().writeCsv("profile.csv")) TraceLog(LOG_INFO, "Perfil guardado en profile.csv");
+#endif
 
-                    if (spawnTimer <= 0) {
-                        GameObjectList sCol;
-                        qt.query(ship.getBounds(), sCol);
-                        for(int i = 0; i < sCol.size(); i++) if(sCol.get(i).type == 2) {
-                            lives--; ship.position = {(float)SCREEN_WIDTH/3, (float)SCREEN_HEIGHT/2}; shipVel = {0,0}; spawnTimer = 3.0f; break;
-                        }
-                    }
+        UploadLoadedAssets();
 
-                    for (int i = 0; i < MAX_BULLETS; i++) if (bulData[i].active) {
-                        bullets[i].position.x += bulData[i].velocity.x; bullets[i].position.y += bulData[i].velocity.y;
-                        if (bullets[i].position.x < 0 || bullets[i].position.x > SCREEN_WIDTH || bullets[i].position.y < 0 || bullets[i].position.y > SCREEN_HEIGHT) bulData[i].active = false;
-                        else {
-                            GameObjectList bCol; qt.query(CustomRectangle(bullets[i].position.x, bullets[i].position.y, 10, 10), bCol);
-                            for (int j = 0; j < bCol.size(); j++) if (bCol.get(j).type == 2) {
-                                bulData[i].active = false;
-                                for(int k=0; k<MAX_ASTEROIDS; k++) if(astData[k].active && asteroids[k].id == bCol.get(j).id) {
-                                    SplitAsteroid(k, bullets[i].type == 3);
-                                    PlaySound(fxExplosion);
-                                    for(int e=0; e<MAX_EXPLOSIONS; e++) if(!explosions[e].active) {
-                                        explosions[e].active = true; explosions[e].position = {bCol.get(j).position.x, bCol.get(j).position.y};
-                                        explosions[e].currentFrame = 0; explosions[e].scale = (float)astData[k].size * 80.0f; break;
-                                    }
-                                    break;
-                                }
-                                break;
-                            }
-                        }
-                    }
-                    break;
-                }
-            case GAME_PAUSED:
-                
-                if (IsKeyPressed(KEY_ESCAPE)) currentGameState = GAME_PLAYING;
-                if (IsKeyPressed(KEY_Q)) currentGameState = GAME_MENU;
-                break;
-
-            case GAME_OVER:
-                if (IsKeyPressed(KEY_ENTER)) currentGameState = GAME_MENU;
-                break;
+        // La música solo existe una vez cargados los recursos
+        if (assetsReady) {
+            if (IsMusicStreamPlaying(music)) {
+                UpdateMusicStream(music);
             }
+            else if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) || GetKeyPressed() > 0) {
+                PlayMusicStream(music);
+            }
+        }
+        if (session->state == GAME_MENU) {
+            if (IsKeyPressed(KEY_UP) || IsKeyPressed(KEY_DOWN)) playWithBot = !playWithBot;
+            if (assetsReady && IsKeyPressed(KEY_ENTER)) { ResetGame(); session->state = GAME_PLAYING; }
+        }
+        else {
+            // Las teclas del frame van a la sesión (y a la grabación) como bits
+            unsigned int keys = 0;
+            if (IsKeyDown(KEY_W)) keys |= INPUT_W;
+            if (IsKeyDown(KEY_A)) keys |= INPUT_A;
+            if (IsKeyDown(KEY_S)) keys |= INPUT_S;
+            if (IsKeyDown(KEY_D)) keys |= INPUT_D;
+            if (IsKeyPressed(KEY_Q)) keys |= INPUT_Q;
+            if (IsKeyPressed(KEY_ESCAPE)) keys |= INPUT_ESC;
+            if (IsKeyPressed(KEY_ENTER)) keys |= INPUT_ENTER;
+            session->frame(keys, GetFrameTime());
+
+            // La simulación no tiene audio: solo cuenta los eventos de cada tick
+            if (session->shots > 0) PlaySound(fxShot);
+            if (session->hits > 0) PlaySound(fxExplosion);
+            if (session->state == GAME_MENU) SaveReplay();
+        }
 
             BeginDrawing();
+            PROFILE_BEGIN(PROFILE_DRAW);
     ClearBackground(BLACK);
-    DrawTexturePro(background, {0,0,(float)background.width, (float)background.height}, {0,0,(float)SCREEN_WIDTH, (float)SCREEN_HEIGHT}, {0,0}, 0, WHITE);
+    if (background.id > 0) DrawTexturePro(background, {0,0,(float)background.width, (float)background.height}, {0,0,(float)SCREEN_WIDTH, (float)SCREEN_HEIGHT}, {0,0}, 0, WHITE);
 
-    if (currentGameState == GAME_MENU) {
+    if (session->state == GAME_MENU) {
         DrawText("DUO ASTEROID HUNTER", SCREEN_WIDTH/2 - 350, SCREEN_HEIGHT/2 - 150, 60, RAYWHITE);
         Color soloColor = (!playWithBot) ? YELLOW : GRAY; Color botColor = (playWithBot) ? YELLOW : GRAY;
         DrawText(playWithBot ? "  SOLO MODE" : "> SOLO MODE", SCREEN_WIDTH/2 - 120, SCREEN_HEIGHT/2, 30, soloColor);
         DrawText(playWithBot ? "> DUO MODE (WITH BOT)" : "  DUO MODE (WITH BOT)", SCREEN_WIDTH/2 - 120, SCREEN_HEIGHT/2 + 50, 30, botColor);
         DrawText("FIRST TO 3000 WINS!", SCREEN_WIDTH/2 - 140, SCREEN_HEIGHT/2 + 110, 25, GREEN);
-        DrawText("PRESS ENTER TO START", SCREEN_WIDTH/2 - 160, SCREEN_HEIGHT/2 + 180, 25, LIGHTGRAY);
+        if (assetsReady) DrawText("PRESS ENTER TO START", SCREEN_WIDTH/2 - 160, SCREEN_HEIGHT/2 + 180, 25, LIGHTGRAY);
+        else DrawText(TextFormat("LOADING... %i / %i", assetsUploaded, (int)LOAD_COUNT), SCREEN_WIDTH/2 - 110, SCREEN_HEIGHT/2 + 180, 25, LIGHTGRAY);
     }
-    else if (currentGameState == GAME_PLAYING || currentGameState == GAME_PAUSED || currentGameState == GAME_OVER) {
-        Color shipC = (spawnTimer > 0) ? Fade(SKYBLUE, 0.5f) : WHITE;
+    else {
+        Color shipC = (sim->spawnTimer > 0) ? Fade(SKYBLUE, 0.5f) : WHITE;
 
         float shipSize = 75.0f;
-        float origin = shipSize / 2.0f;
-
-        DrawTexturePro(shipTex, {0,0,(float)shipTex.width,(float)shipTex.height},
-               {ship.position.x, ship.position.y, shipSize, shipSize},
-               {origin, origin}, visualRotation + 90, shipC);
 
-        if(bot.active) {
-            DrawTexturePro(shipTex, {0,0,(float)shipTex.width,(float)shipTex.height},
-                           {bot.entity.position.x, bot.entity.position.y, shipSize, shipSize},
-                           {origin, origin}, bot.rotation + 90, RED);
+        Rectangle view = { 0, 0, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
+        Rectangle shipSrc = { 0, 0, (float)shipTex.width, (float)shipTex.height };
+        float alpha = session->alpha();
+        // Solo un mundo mayor que la pantalla sigue a la nave
+        if (sim->width > SCREEN_WIDTH || sim->height > SCREEN_HEIGHT) {
+            camera = TickPosition(sim->shipPrev.x, sim->shipPrev.y, sim->ship.position.x, sim->ship.position.y, alpha);
+        } else {
+            camera = { sim->width * 0.5f, sim->height * 0.5f };
         }
-
-        for(int i=0; i<MAX_ASTEROIDS; i++) if(astData[i].active) {
-            
-            float r = (float)astData[i].size * 17.0f;
-
-            DrawTexturePro(asteroidTex, {0,0,(float)asteroidTex.width,(float)asteroidTex.height},
-                          {asteroids[i].position.x, asteroids[i].position.y, r*2, r*2},
-                          {r, r}, 0, WHITE);
+        shipBatch.begin(shipTex, view);
+        shipBatch.add(shipSrc, ViewPosition(sim->shipPrev.x, sim->shipPrev.y, sim->ship.position.x, sim->ship.position.y, alpha), shipSize, shipSize, sim->visualRotation + 90, shipC);
+        for(int i=0; i<sim->botCount; i++) {
+            const BotPlayer& bot = sim->bots[i];
+            shipBatch.add(shipSrc, ViewPosition(bot.prevPosition.x, bot.prevPosition.y, bot.entity.position.x, bot.entity.position.y, alpha), shipSize, shipSize, bot.rotation + 90, RED);
         }
-
-        for (int i = 0; i < MAX_EXPLOSIONS; i++) {
-            if (explosions[i].active) {
-               
-                explosions[i].frameCounter++;
-                if (explosions[i].frameCounter >= 5) {
-                    explosions[i].currentFrame++;
-                    explosions[i].frameCounter = 0;
-                }
-
-                if (explosions[i].currentFrame >= 6) {
-                    explosions[i].active = false;
-                } else {
-                 
-                    int frameWidth = explosionTex.width / 6;
-                    int frameHeight = explosionTex.height;
-
-                    
-                    Rectangle src = {
-                        (float)(explosions[i].currentFrame * frameWidth),
-                        0.0f,
-                        (float)frameWidth,
-                        (float)frameHeight
-                    };
-
-                    
-                    float drawW = explosions[i].scale;
-                   
-                    float drawH = drawW * ((float)frameHeight / (float)frameWidth);
-
-                    Rectangle dst = {
-                        explosions[i].position.x,
-                        explosions[i].position.y,
-                        drawW,
-                        drawH
-                    };
-
-                    Vector2 origin = { drawW / 2.0f, drawH / 2.0f };
-
-                    DrawTexturePro(explosionTex, src, dst, origin, 0.0f, WHITE);
-                }
+        shipBatch.flush();
+
+        Rectangle asteroidSrc = { 0, 0, (float)asteroidTex.width, (float)asteroidTex.height };
+        asteroidBatch.begin(asteroidTex, view);
+        // Los que tocan la pantalla (más el radio del mayor) según el broadphase, no todos los despiertos
+        int visibleCount = sim->visibleAsteroids(CustomRectangle(camera.x, camera.y, SCREEN_WIDTH + 128.0f, SCREEN_HEIGHT + 128.0f), visibleAsteroids);
+        for(int v=0; v<visibleCount; v++) {
+            int i = visibleAsteroids[v];
+            float r = (float)sim->asteroids.size[i] * 17.0f;
+            asteroidBatch.add(asteroidSrc, ViewPosition(sim->asteroids.prevX[i], sim->asteroids.prevY[i], sim->asteroids.x[i], sim->asteroids.y[i], alpha), r*2, r*2, 0, WHITE);
+        }
+        asteroidBatch.flush();
+
+        // La simulación ya las movió: aquí solo se reparten en tres lotes en una pasada.
+        // El cuadro del fogonazo sale de lo que le queda de vida.
+        const ParticleSystem& particles = sim->particles;
+        float explosionAspect = explosionFrames[0].height / explosionFrames[0].width;
+        explosionBatch.begin(explosionTex, view);
+        debrisBatch.begin(asteroidTex, view);
+        sparkBatch.begin(bulletAtlas, view);
+        for (int n = 0; n < particles.window(); n++) {
+            int i = particles.index(particles.first() + (unsigned)n);
+            float fade = particles.fade[i];
+            if (fade <= 0) continue;
+            Vector2 pos = ViewPosition(particles.prevX[i], particles.prevY[i], particles.x[i], particles.y[i], alpha);
+            float s = particles.size[i];
+            if (particles.kind[i] == PARTICLE_FLASH) {
+                int frame = (int)((1.0f - fade) * EXPLOSION_FRAMES);
+                if (frame >= EXPLOSION_FRAMES) frame = EXPLOSION_FRAMES - 1;
+                explosionBatch.add(explosionFrames[frame], pos, s, s * explosionAspect, 0, WHITE);
+            } else if (particles.kind[i] == PARTICLE_DEBRIS) {
+                debrisBatch.add(asteroidSrc, pos, s, s, 0, Fade(LIGHTGRAY, fade));
+            } else {
+                sparkBatch.add(BULLET_PLAYER_SRC, pos, s, s, 0, Fade(ORANGE, fade));
             }
         }
-        for(int i=0; i<MAX_BULLETS; i++) if(bulData[i].active) DrawCircle(bullets[i].position.x, bullets[i].position.y, 4, (bullets[i].type == 3) ? YELLOW : ORANGE);
-        DrawText(TextFormat("PLAYER: %i / %i", playerScore, WIN_SCORE), 40, 40, 30, RAYWHITE);
-        if(bot.active) DrawText(TextFormat("BOT: %i / %i", bot.score, WIN_SCORE), 40, 75, 30, RED);
-        DrawText(TextFormat("LIVES: %i", lives), 40, 110, 30, GREEN);
+        explosionBatch.flush();
+        debrisBatch.flush();
+        sparkBatch.flush();
+
+        bulletBatch.begin(bulletAtlas, view);
+        for(int i=0; i<sim->bullets.count; i++) {
+            bulletBatch.add((sim->bullets.type[i] == 3) ? BULLET_PLAYER_SRC : BULLET_BOT_SRC,
+                            ViewPosition(sim->bullets.prevX[i], sim->bullets.prevY[i], sim->bullets.x[i], sim->bullets.y[i], alpha), BULLET_CELL, BULLET_CELL, 0, WHITE);
+        }
+        bulletBatch.flush();
+        DrawText(TextFormat("PLAYER: %i / %i", sim->playerScore, WIN_SCORE), 40, 40, 30, RAYWHITE);
+        if(sim->botCount == 1) DrawText(TextFormat("BOT: %i / %i", sim->bots[0].score, WIN_SCORE), 40, 75, 30, RED);
+        else if(sim->botCount > 1) DrawText(TextFormat("BOTS (%i): %i / %i", sim->botCount, sim->bestBotScore(), WIN_SCORE), 40, 75, 30, RED);
+        DrawText(TextFormat("LIVES: %i", sim->lives), 40, 110, 30, GREEN);
 
-        if (currentGameState == GAME_PAUSED) {
+        if (session->state == GAME_PAUSED) {
             DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Fade(BLACK, 0.6f));
             DrawText("PAUSA", SCREEN_WIDTH/2 - 80, SCREEN_HEIGHT/2 - 40, 50, YELLOW);
             DrawText("ESC para continuar - Q para salir", SCREEN_WIDTH/2 - 180, SCREEN_HEIGHT/2 + 20, 20, RAYWHITE);
         }
-        if (currentGameState == GAME_OVER) {
+        if (session->state == GAME_OVER) {
             DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Fade(BLACK, 0.8f));
-            if (playerWon) DrawText("YOU WIN!", SCREEN_WIDTH/2 - 140, SCREEN_HEIGHT/2 - 50, 60, GOLD);
+            if (session->playerWon) DrawText("YOU WIN!", SCREEN_WIDTH/2 - 140, SCREEN_HEIGHT/2 - 50, 60, GOLD);
             else DrawText("GAME OVER", SCREEN_WIDTH/2 - 160, SCREEN_HEIGHT/2 - 50, 60, RED);
             DrawText("ENTER PARA VOLVER AL MENU", SCREEN_WIDTH/2 - 180, SCREEN_HEIGHT/2 + 20, 20, LIGHTGRAY);
         }
     }
+#if defined(ASTEROID_PROFILER)
+    if (showProfiler) DrawProfilerOverlay();
+#endif
+    // EndDrawing espera al siguiente refresco: queda fuera de la medida
+    PROFILE_END(PROFILE_DRAW);
+    PROFILE_END(PROFILE_FRAME);
+    PROFILE_END_FRAME();
     EndDrawing();
+    if (!firstFrameShown) {
+        firstFrameShown = true;
+        TraceLog(LOG_INFO, "Primer frame a los %.2f ms", ElapsedMs(startTime));
+    }
 }
-int main() {
+int main(int argc, char** argv) {
+    startTime = std::chrono::steady_clock::now();
+    const char* broadphaseName = "loose";
+    bool bakeOnly = false;
+    const char* playbackPath = nullptr;
+    int tickRate = SIM_BASE_TICK_RATE;
+#if defined(PLATFORM_WEB)
+    int workerThreads = 0; // sin pthreads en la versión web
+#else
+    int workerThreads = JobSystem::defaultWorkers();
+#endif
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--broadphase") == 0 && i + 1 < argc) broadphaseName = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) workerThreads = atoi(argv[++i]) - 1;
+        else if (strcmp(argv[i], "--bots") == 0 && i + 1 < argc) duoBots = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) tickRate = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--bake-assets") == 0) bakeOnly = true;
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) replayPath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) playbackPath = argv[++i];
+        else if (strcmp(argv[i], "--world") == 0 && i + 1 < argc) worldScreens = atoi(argv[++i]);
+    }
+    if (duoBots < 1) duoBots = 1;
+    if (worldScreens < 1) worldScreens = 1;
+    SimConfig config;
+    config.broadphase = broadphaseName;
+    config.workerThreads = workerThreads;
+    config.botCapacity = duoBots;
+    config.bulletCapacity = MAX_BULLETS + BULLETS_PER_BOT * duoBots;
+    if (tickRate < 1) tickRate = SIM_BASE_TICK_RATE;
+    config.tickRate = tickRate;
+    if (worldScreens > 1) {
+        // La capacidad es para los despiertos alrededor de la nave y de cada bot
+        config.sectorWidth = (float)SCREEN_WIDTH;
+        config.sectorHeight = (float)SCREEN_HEIGHT;
+        config.asteroidCapacity = MAX_ASTEROIDS * (1 + duoBots);
+    }
+    // --replay: la partida grabada lleva su propia configuración; solo se eligen los hilos
+    if (playbackPath) return PlayReplayFile(playbackPath, workerThreads, 3);
+    sim = new GameSim((float)(SCREEN_WIDTH * worldScreens), (float)(SCREEN_HEIGHT * worldScreens), config);
+    visibleAsteroids = new int[sim->asteroids.getCapacity()];
+    session = new GameSession(sim, tickRate);
+    session->setRecording(&replay, config);
+    if (bakeOnly) {
+        int result = BakeAssets();
+        delete session;
+        delete[] visibleAsteroids;
+        delete sim;
+        return result;
+    }
+
     InitWindow(1280, 720, "Asteroid Hunter");
         SetExitKey(0);
     InitAudioDevice();
     SetTargetFPS(60);
 
-    background = LoadTexture("resources/space_bg3.png");
-
-    Image imgNave = LoadImage("resources/ship0.png");
-    SuperCleanSprite(&imgNave, false);
-    shipTex = LoadTextureFromImage(imgNave);
-    UnloadImage(imgNave);
-
-    Image imgAst = LoadImage("resources/asteroid0.png");
-    SuperCleanSprite(&imgAst, false);
-    asteroidTex = LoadTextureFromImage(imgAst);
-    UnloadImage(imgAst);
-
-    Image imgExp = LoadImage("resources/explosion7.png");
-    SuperCleanSprite(&imgExp, true);
-
-    explosionTex = LoadTextureFromImage(imgExp);
-    SetTextureFilter(explosionTex, TEXTURE_FILTER_POINT);
-    UnloadImage(imgExp);
-
-
-    fxShot = LoadSound("resources/shot.wav");
-    fxExplosion = LoadSound("resources/explosion.wav");
-    music = LoadMusicStream("resources/music1.mp3");
+    // Imágenes, sonidos y música se decodifican en otros hilos; UpdateDrawFrame los sube según llegan
+    int loaderThreads = workerThreads;
+#if !defined(PLATFORM_WEB)
+    if (loaderThreads < 1) loaderThreads = 1;
+#endif
+    assetCache = new AssetCache(ASSET_CACHE_PATH);
+    assetLoader = new AssetLoader(*assetCache, LOAD_COUNT);
+    for (int i = 0; i < LOAD_COUNT; i++) assetLoader->add(GAME_ASSETS[i].path, GAME_ASSETS[i].kind, GAME_ASSETS[i].mode);
+    assetLoader->start(loaderThreads);
 
-    SetSoundVolume(fxShot, 0.5f);
-    SetSoundVolume(fxExplosion, 0.5f);
-    SetMusicVolume(music, 0.4f);
+    // Mismos círculos de radio 4 que dibujaba DrawCircle, en una textura para poder agruparlos
+    Image imgBullets = GenImageColor((int)(BULLET_CELL * 2), (int)BULLET_CELL, BLANK);
+    ImageDrawCircle(&imgBullets, (int)(BULLET_CELL / 2), (int)(BULLET_CELL / 2), 4, YELLOW);
+    ImageDrawCircle(&imgBullets, (int)(BULLET_CELL * 1.5f), (int)(BULLET_CELL / 2), 4, ORANGE);
+    bulletAtlas = LoadTextureFromImage(imgBullets);
+    UnloadImage(imgBullets);
 
-    ship.position = { 1280.0f/2, 720.0f/2 };
-        ship.width = 40;
-        ship.height = 40;ship.id = 9999;
 
-        bot.entity.width = 30;
-        bot.entity.height = 30;
     ResetGame();
 
 #if defined(PLATFORM_WEB)
@@ -480,13 +471,20 @@ int main() {
     while (!WindowShouldClose()) {
         UpdateDrawFrame();
     }
+    if (session->state != GAME_MENU) SaveReplay();
 
 
     UnloadSound(fxShot);
     UnloadSound(fxExplosion);
+    delete assetLoader;
+    delete assetCache;
     UnloadMusicStream(music);
+    UnloadFileData(musicData);
     CloseAudioDevice();
     CloseWindow();
+    delete session;
+    delete[] visibleAsteroids;
+    delete sim;
 #endif
         SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     return 0;
@@ -0,0 +1,199 @@
+#include "broadphase.h"
+#include "loosequadtree.h"
+#include "spatialhash.h"
+
+#include <cstring>
+
+void Broadphase::queryBatch(const CustomRectangle* ranges, int rangeCount, QueryBatch& out) {
+    out.clear();
+    for (int r = 0; r < rangeCount; r++) {
+        out.beginRange();
+        for (int h : queryHandles(ranges[r])) out.add(h);
+    }
+}
+
+QuadTreeBroadphase::QuadTreeBroadphase(const CustomRectangle& world)
+    : tree(world), items(nullptr), alive(nullptr), stamps(nullptr),
+      handleCapacity(0), maxHandle(-1), stamp(0), dirty(false),
+      scratch(nullptr), scratchCapacity(0),
+      packed(nullptr), packedHandles(nullptr), jobs(nullptr) {}
+
+QuadTreeBroadphase::~QuadTreeBroadphase() {
+    delete[] items;
+    delete[] alive;
+    delete[] stamps;
+    delete[] scratch;
+    delete[] packed;
+    delete[] packedHandles;
+}
+
+void QuadTreeBroadphase::reserveHandles(int handle) {
+    if (handle < handleCapacity) return;
+    int newCap = handleCapacity > 0 ? handleCapacity * 2 : 64;
+    while (newCap <= handle) newCap *= 2;
+    GameObject* newItems = new GameObject[newCap];
+    unsigned char* newAlive = new unsigned char[newCap];
+    unsigned* newStamps = new unsigned[newCap];
+    for (int h = 0; h < newCap; h++) {
+        if (h < handleCapacity) {
+            newItems[h] = items[h];
+            newAlive[h] = alive[h];
+            newStamps[h] = stamps[h];
+        } else {
+            newAlive[h] = 0;
+            newStamps[h] = 0;
+        }
+    }
+    delete[] items; delete[] alive; delete[] stamps;
+    items = newItems; alive = newAlive; stamps = newStamps;
+    delete[] scratch;
+    delete[] packed;
+    delete[] packedHandles;
+    scratch = new int[newCap];
+    packed = new GameObject[newCap];
+    packedHandles = new int[newCap];
+    scratchCapacity = newCap;
+    handleCapacity = newCap;
+}
+
+void QuadTreeBroadphase::rebuild() {
+    int n = 0;
+    for (int h = 0; h <= maxHandle; h++) {
+        if (!alive[h]) continue;
+        packed[n] = items[h];
+        packedHandles[n] = h;
+        n++;
+    }
+    tree.build(packed, packedHandles, n, jobs);
+    dirty = false;
+}
+
+void QuadTreeBroadphase::insert(const GameObject& object, int handle) {
+    if (handle < 0) return;
+    reserveHandles(handle);
+    if (handle > maxHandle) maxHandle = handle;
+    // Si el handle ya estaba, su copia vieja sigue en el árbol: la consulta la filtra
+    items[handle] = object;
+    alive[handle] = 1;
+    if (!dirty) tree.insert(object, handle);
+}
+
+void QuadTreeBroadphase::update(int handle, const CustomRectangle& newBounds) {
+    if (handle < 0 || handle >= handleCapacity || !alive[handle]) return;
+    items[handle].position = Point(newBounds.x, newBounds.y);
+    items[handle].width = newBounds.width;
+    items[handle].height = newBounds.height;
+    dirty = true;
+}
+
+void QuadTreeBroadphase::remove(int handle) {
+    if (handle >= 0 && handle < handleCapacity) alive[handle] = 0;
+}
+
+void QuadTreeBroadphase::clear() {
+    for (int h = 0; h <= maxHandle; h++) alive[h] = 0;
+    maxHandle = -1;
+    tree.clear();
+    dirty = false;
+}
+
+void QuadTreeBroadphase::maintain() {
+    if (dirty) rebuild();
+}
+
+HandleSpan QuadTreeBroadphase::queryHandles(const CustomRectangle& range) {
+    if (dirty) rebuild();
+    if (++stamp == 0) {
+        for (int h = 0; h < handleCapacity; h++) stamps[h] = 0;
+        stamp = 1;
+    }
+    // El árbol puede guardar copias de handles borrados o reinsertados desde la última reconstrucción
+    int count = 0;
+    HandleSpan raw = tree.queryHandles(range);
+    PROFILE_COUNT(PROFILE_QUERIES, 1);
+    PROFILE_COUNT(PROFILE_TESTED, raw.count);
+    for (int h : raw) {
+        if (!alive[h] || stamps[h] == stamp) continue;
+        stamps[h] = stamp;
+        if (range.intersects(items[h].getBounds())) scratch[count++] = h;
+    }
+    HandleSpan span = { scratch, count };
+    return span;
+}
+
+void QuadTreeBroadphase::queryBatch(const CustomRectangle* ranges, int rangeCount, QueryBatch& out) {
+    if (dirty) rebuild();
+    tree.queryBatch(ranges, rangeCount, rawBatch);
+    out.clear();
+    PROFILE_COUNT(PROFILE_QUERIES, rangeCount);
+    for (int r = 0; r < rangeCount; r++) {
+        if (++stamp == 0) {
+            for (int h = 0; h < handleCapacity; h++) stamps[h] = 0;
+            stamp = 1;
+        }
+        out.beginRange();
+        PROFILE_COUNT(PROFILE_TESTED, rawBatch.get(r).count);
+        for (int h : rawBatch.get(r)) {
+            if (!alive[h] || stamps[h] == stamp) continue;
+            stamps[h] = stamp;
+            if (ranges[r].intersects(items[h].getBounds())) out.add(h);
+        }
+    }
+}
+
+int QuadTreeBroadphase::nearest(const Point& p, int k, float maxRadius, int type, NearestQueue& queue,
+                                int* outHandles, float* outDist2) const {
+    // Una copia vieja de un handle reinsertado no coincide con su posición actual: se ignora.
+    // Si coincide, el árbol descarta el handle repetido.
+    int tested = 0;
+    int found = tree.nearest(p, k, maxRadius, [this, type, &tested](const GameObject& obj, int h) {
+        tested++;
+        if (!alive[h]) return false;
+        const GameObject& cur = items[h];
+        if (cur.position.x != obj.position.x || cur.position.y != obj.position.y) return false;
+        return type == -1 || cur.type == type;
+    }, queue, outHandles, outDist2);
+    PROFILE_COUNT(PROFILE_QUERIES, 1);
+    PROFILE_COUNT(PROFILE_TESTED, tested);
+    return found;
+}
+
+int QuadTreeBroadphase::findFirst(const CustomRectangle& range, int type) const {
+    // Mismo filtro que queryHandles pero sin marcas: el primero que pasa es el mismo
+    int found = -1;
+    int tested = 0;
+    tree.scan(range, [&](const GameObject&, int h) {
+        tested++;
+        if (!alive[h] || !range.intersects(items[h].getBounds())) return true;
+        if (type != -1 && items[h].type != type) return true;
+        found = h;
+        return false;
+    });
+    PROFILE_COUNT(PROFILE_QUERIES, 1);
+    PROFILE_COUNT(PROFILE_TESTED, tested);
+    return found;
+}
+
+int QuadTreeBroadphase::sweepFirst(const Point& from, const Point& to, float hx, float hy, int type, float& toi) const {
+    // Como en nearest: solo cuenta la copia que coincide con el estado actual del handle
+    int tested = 0;
+    int found = tree.sweep(from, to, hx, hy, [this, type](const GameObject& obj, int h) {
+        if (!alive[h]) return false;
+        const GameObject& cur = items[h];
+        if (cur.position.x != obj.position.x || cur.position.y != obj.position.y ||
+            cur.width != obj.width || cur.height != obj.height) return false;
+        return type == -1 || cur.type == type;
+    }, toi, &tested);
+    PROFILE_COUNT(PROFILE_QUERIES, 1);
+    PROFILE_COUNT(PROFILE_TESTED, tested);
+    return found;
+}
+
+Broadphase* CreateBroadphase(const char* name, const CustomRectangle& world) {
+    if (name == nullptr || strcmp(name, "loose") == 0) return new LooseQuadTree(world);
+    if (strcmp(name, "quadtree") == 0) return new QuadTreeBroadphase(world);
+    if (strcmp(name, "grid") == 0) {
+        return new SpatialHash(world.x - world.width/2, world.y - world.height/2, world.width, world.height);
+    }
+    return nullptr;
+}
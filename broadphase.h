@@ -0,0 +1,96 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include "quadtree.h"
+#include "profiler.h"
+
+// Interfaz común de los índices espaciales del juego. Los objetos se identifican por un
+// handle (su slot en el arreglo del llamador); cada implementación decide si los mueve
+// en sitio o si reconstruye su estructura en maintain().
+class Broadphase {
+public:
+    virtual ~Broadphase() {}
+    virtual void insert(const GameObject& object, int handle) = 0;
+    virtual void update(int handle, const CustomRectangle& newBounds) = 0;
+    virtual void remove(int handle) = 0;
+    virtual void clear() = 0;
+    // Se llama una vez por frame, después de mover todos los objetos
+    virtual void maintain() = 0;
+    // Handles únicos que intersectan 'range'; la vista vale hasta la siguiente consulta
+    virtual HandleSpan queryHandles(const CustomRectangle& range) = 0;
+    // Varios rangos a la vez; por defecto equivale a una queryHandles por rango
+    virtual void queryBatch(const CustomRectangle* ranges, int rangeCount, QueryBatch& out);
+    // Los k handles con el centro más cerca de 'p' (como mucho a maxRadius), de cerca a lejos.
+    // 'type' filtra por GameObject::type (-1 = cualquiera). Devuelve cuántos escribió en outHandles.
+    // 'queue' es memoria de trabajo del llamador: con una por hilo se puede consultar desde
+    // varios hilos a la vez después de maintain().
+    virtual int nearest(const Point& p, int k, float maxRadius, int type, NearestQueue& queue,
+                        int* outHandles, float* outDist2 = nullptr) const = 0;
+    // Primer handle de tipo 'type' (-1 = cualquiera) que intersecta 'range', en el orden de queryHandles,
+    // o -1. No modifica nada: varios hilos pueden llamarlo a la vez después de maintain().
+    virtual int findFirst(const CustomRectangle& range, int type) const = 0;
+    // Primer handle de tipo 'type' (-1 = cualquiera) que toca una caja de semiextensión (hx, hy)
+    // al moverse de 'from' a 'to' (con hx = hy = 0, un segmento), o -1. 'toi' recibe la fracción
+    // del trayecto en [0, 1] del contacto. Solo lectura, como findFirst.
+    virtual int sweepFirst(const Point& from, const Point& to, float hx, float hy, int type, float& toi) const = 0;
+    virtual const GameObject& get(int handle) const = 0;
+    virtual const char* name() const = 0;
+    // Hilos para las reconstrucciones de maintain(); los broadphases incrementales lo ignoran
+    virtual void setJobSystem(JobSystem*) {}
+    // Estadísticas para el perfilador: nodos (o celdas) y reservas de memoria acumuladas
+    virtual int nodeTotal() const = 0;
+    virtual long long allocationCount() const = 0;
+};
+
+// Adaptador del QuadTree clásico: se reconstruye entero en maintain() si algo se movió.
+// Las altas entre reconstrucciones se añaden al árbol y las bajas se filtran al consultar.
+class QuadTreeBroadphase : public Broadphase {
+private:
+    QuadTree tree;
+    GameObject* items;
+    unsigned char* alive;
+    unsigned* stamps;
+    int handleCapacity;
+    int maxHandle;
+    unsigned stamp;
+    bool dirty;
+    int* scratch;
+    int scratchCapacity;
+    QueryBatch rawBatch;
+    // Objetos vivos empaquetados para QuadTree::build
+    GameObject* packed;
+    int* packedHandles;
+    JobSystem* jobs;
+
+    void reserveHandles(int handle);
+    void rebuild();
+
+    QuadTreeBroadphase(const QuadTreeBroadphase&) = delete;
+    QuadTreeBroadphase& operator=(const QuadTreeBroadphase&) = delete;
+public:
+    explicit QuadTreeBroadphase(const CustomRectangle& world);
+    ~QuadTreeBroadphase();
+    void insert(const GameObject& object, int handle) override;
+    void update(int handle, const CustomRectangle& newBounds) override;
+    void remove(int handle) override;
+    void clear() override;
+    void maintain() override;
+    HandleSpan queryHandles(const CustomRectangle& range) override;
+    void queryBatch(const CustomRectangle* ranges, int rangeCount, QueryBatch& out) override;
+    int nearest(const Point& p, int k, float maxRadius, int type, NearestQueue& queue,
+                int* outHandles, float* outDist2 = nullptr) const override;
+    int findFirst(const CustomRectangle& range, int type) const override;
+    int sweepFirst(const Point& from, const Point& to, float hx, float hy, int type, float& toi) const override;
+    const GameObject& get(int handle) const override { return items[handle]; }
+    const char* name() const override { return "quadtree"; }
+    void setJobSystem(JobSystem* j) override { jobs = j; }
+    int nodeTotal() const override { return tree.nodeTotal(); }
+    long long allocationCount() const override { return tree.allocationCount(); }
+
+    const QuadTree& getTree() const { return tree; }
+};
+
+// Crea el broadphase por nombre: "quadtree", "loose" o "grid". Devuelve nullptr si no existe.
+Broadphase* CreateBroadphase(const char* name, const CustomRectangle& world);
+
+#endif
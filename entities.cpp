@@ -0,0 +1,193 @@
+#include "entities.h"
+
+#include <cstring>
+
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define ENTITIES_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define ENTITIES_SSE2 1
+#endif
+
+SlotMap::SlotMap(int cap) : capacity(cap < 1 ? 1 : cap), count(0) {
+    if (capacity > MAX_ENTITY_SLOTS) capacity = MAX_ENTITY_SLOTS;
+    slotToDense = new int[capacity];
+    denseToSlot = new int[capacity];
+    generation = new unsigned[capacity];
+    freeSlots = new int[capacity];
+    for (int s = 0; s < capacity; s++) generation[s] = 0;
+    clear();
+}
+
+SlotMap::~SlotMap() {
+    delete[] slotToDense;
+    delete[] denseToSlot;
+    delete[] generation;
+    delete[] freeSlots;
+}
+
+void SlotMap::retire(int slot) {
+    // Nueva generación: los handles que apuntaban a este slot quedan caducados
+    generation[slot] = (generation[slot] + 1) & ((1u << (32 - ENTITY_SLOT_BITS)) - 1);
+}
+
+int SlotMap::allocate() {
+    if (freeCount == 0) return -1;
+    int slot = freeSlots[--freeCount];
+    int i = count++;
+    slotToDense[slot] = i;
+    denseToSlot[i] = slot;
+    return i;
+}
+
+int SlotMap::release(int i) {
+    int slot = denseToSlot[i];
+    retire(slot);
+    slotToDense[slot] = -1;
+    freeSlots[freeCount++] = slot;
+
+    int last = --count;
+    if (i == last) return -1;
+    int movedSlot = denseToSlot[last];
+    denseToSlot[i] = movedSlot;
+    slotToDense[movedSlot] = i;
+    return last;
+}
+
+void SlotMap::clear() {
+    // Las generaciones se conservan para que los handles de antes del clear no resuelvan
+    for (int i = 0; i < count; i++) retire(denseToSlot[i]);
+    // Los slots bajos salen primero de la pila
+    for (int s = 0; s < capacity; s++) {
+        slotToDense[s] = -1;
+        freeSlots[s] = capacity - 1 - s;
+    }
+    freeCount = capacity;
+    count = 0;
+}
+
+EntityStore::EntityStore(int cap) : slots(cap), count(0) {
+    int capacity = slots.getCapacity();
+    x = new float[capacity];
+    y = new float[capacity];
+    vx = new float[capacity];
+    vy = new float[capacity];
+    size = new int[capacity];
+    type = new int[capacity];
+    owner = new int[capacity];
+    prevX = new float[capacity];
+    prevY = new float[capacity];
+}
+
+EntityStore::~EntityStore() {
+    delete[] x;
+    delete[] y;
+    delete[] vx;
+    delete[] vy;
+    delete[] size;
+    delete[] type;
+    delete[] owner;
+    delete[] prevX;
+    delete[] prevY;
+}
+
+int EntityStore::spawn() {
+    int i = slots.allocate();
+    if (i == -1) return -1;
+    count = slots.count;
+    x[i] = y[i] = vx[i] = vy[i] = 0;
+    prevX[i] = prevY[i] = 0;
+    size[i] = 0;
+    type[i] = 0;
+    owner[i] = -1;
+    return i;
+}
+
+void EntityStore::kill(int i) {
+    int last = slots.release(i);
+    count = slots.count;
+    if (last == -1) return;
+    x[i] = x[last];
+    y[i] = y[last];
+    vx[i] = vx[last];
+    vy[i] = vy[last];
+    size[i] = size[last];
+    type[i] = type[last];
+    owner[i] = owner[last];
+    prevX[i] = prevX[last];
+    prevY[i] = prevY[last];
+}
+
+void EntityStore::savePositions() {
+    memcpy(prevX, x, count * sizeof(float));
+    memcpy(prevY, y, count * sizeof(float));
+}
+
+// Envuelve un eje: primero los que pasan de 'limit' van a 0, luego los negativos a 'limit'
+static inline float wrapScalar(float p, float limit) {
+    p = (p > limit) ? 0.0f : p;
+    return (p < 0.0f) ? limit : p;
+}
+
+static void moveWrapAxis(float* p, const float* v, int n, float limit, float scale) {
+    int i = 0;
+#if defined(ENTITIES_AVX)
+    __m256 vlimit = _mm256_set1_ps(limit);
+    __m256 vscale = _mm256_set1_ps(scale);
+    __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        __m256 q = _mm256_add_ps(_mm256_loadu_ps(p + i), _mm256_mul_ps(_mm256_loadu_ps(v + i), vscale));
+        q = _mm256_andnot_ps(_mm256_cmp_ps(q, vlimit, _CMP_GT_OQ), q);
+        __m256 neg = _mm256_cmp_ps(q, zero, _CMP_LT_OQ);
+        q = _mm256_or_ps(_mm256_andnot_ps(neg, q), _mm256_and_ps(neg, vlimit));
+        _mm256_storeu_ps(p + i, q);
+    }
+#elif defined(ENTITIES_SSE2)
+    __m128 vlimit = _mm_set1_ps(limit);
+    __m128 vscale = _mm_set1_ps(scale);
+    __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 q = _mm_add_ps(_mm_loadu_ps(p + i), _mm_mul_ps(_mm_loadu_ps(v + i), vscale));
+        q = _mm_andnot_ps(_mm_cmpgt_ps(q, vlimit), q);
+        __m128 neg = _mm_cmplt_ps(q, zero);
+        q = _mm_or_ps(_mm_andnot_ps(neg, q), _mm_and_ps(neg, vlimit));
+        _mm_storeu_ps(p + i, q);
+    }
+#endif
+    for (; i < n; i++) p[i] = wrapScalar(p[i] + v[i] * scale, limit);
+}
+
+void IntegrateWrap(EntityStore& s, float w, float h, float scale, int begin, int end) {
+    moveWrapAxis(s.x + begin, s.vx + begin, end - begin, w, scale);
+    moveWrapAxis(s.y + begin, s.vy + begin, end - begin, h, scale);
+}
+
+void IntegrateCull(EntityStore& s, float w, float h, float scale, unsigned char* outside) {
+    int n = s.count;
+    int i = 0;
+#if defined(ENTITIES_AVX) || defined(ENTITIES_SSE2)
+    __m128 vw = _mm_set1_ps(w);
+    __m128 vh = _mm_set1_ps(h);
+    __m128 vscale = _mm_set1_ps(scale);
+    __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 px = _mm_add_ps(_mm_loadu_ps(s.x + i), _mm_mul_ps(_mm_loadu_ps(s.vx + i), vscale));
+        __m128 py = _mm_add_ps(_mm_loadu_ps(s.y + i), _mm_mul_ps(_mm_loadu_ps(s.vy + i), vscale));
+        _mm_storeu_ps(s.x + i, px);
+        _mm_storeu_ps(s.y + i, py);
+        __m128 out = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(px, zero), _mm_cmpgt_ps(px, vw)),
+                               _mm_or_ps(_mm_cmplt_ps(py, zero), _mm_cmpgt_ps(py, vh)));
+        int bits = _mm_movemask_ps(out);
+        outside[i + 0] = (unsigned char)(bits & 1);
+        outside[i + 1] = (unsigned char)((bits >> 1) & 1);
+        outside[i + 2] = (unsigned char)((bits >> 2) & 1);
+        outside[i + 3] = (unsigned char)((bits >> 3) & 1);
+    }
+#endif
+    for (; i < n; i++) {
+        s.x[i] += s.vx[i] * scale;
+        s.y[i] += s.vy[i] * scale;
+        outside[i] = (unsigned char)(s.x[i] < 0 || s.x[i] > w || s.y[i] < 0 || s.y[i] > h);
+    }
+}
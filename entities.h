@@ -0,0 +1,109 @@
+#ifndef ENTITIES_H
+#define ENTITIES_H
+
+// Handle generacional: slot en los 20 bits bajos y generación en los 12 altos.
+// Cuando un slot se recicla su generación cambia y los handles viejos dejan de resolver.
+typedef unsigned int EntityHandle;
+const EntityHandle INVALID_ENTITY = 0xFFFFFFFFu;
+const int ENTITY_SLOT_BITS = 20;
+const int MAX_ENTITY_SLOTS = 1 << ENTITY_SLOT_BITS;
+
+// Tabla de slots con lista libre: alta y baja en O(1) y lista densa de vivos.
+// No guarda datos, solo la correspondencia slot <-> índice denso.
+class SlotMap {
+private:
+    int capacity;
+    int* slotToDense;
+    int* denseToSlot;
+    unsigned* generation;
+    int* freeSlots;     // pila de slots libres
+    int freeCount;
+
+    void retire(int slot);
+
+    SlotMap(const SlotMap&) = delete;
+    SlotMap& operator=(const SlotMap&) = delete;
+public:
+    int count;
+
+    explicit SlotMap(int cap);
+    ~SlotMap();
+
+    int getCapacity() const { return capacity; }
+    // Reserva un slot y lo pone al final de la lista densa; devuelve el índice denso o -1
+    int allocate();
+    // Libera el índice denso 'i' moviendo el último a su hueco. Devuelve el índice anterior
+    // del que se movió (el llamador mueve sus datos igual) o -1 si no se movió ninguno.
+    int release(int i);
+    void clear();
+
+    int slotOf(int i) const { return denseToSlot[i]; }
+    // Índice denso del slot, o -1 si está libre
+    int indexOfSlot(int slot) const { return slot >= 0 && slot < capacity ? slotToDense[slot] : -1; }
+    EntityHandle handleOf(int i) const {
+        int slot = denseToSlot[i];
+        return (EntityHandle)slot | (generation[slot] << ENTITY_SLOT_BITS);
+    }
+    // Índice denso del handle, o -1 si ya no existe
+    int find(EntityHandle h) const {
+        if (h == INVALID_ENTITY) return -1;
+        int slot = (int)(h & (MAX_ENTITY_SLOTS - 1));
+        if (slot >= capacity || (h >> ENTITY_SLOT_BITS) != generation[slot]) return -1;
+        return slotToDense[slot];
+    }
+};
+
+// Almacén de entidades en estructura de arreglos (SoA). Las entidades vivas ocupan
+// siempre [0, count) sin huecos, así los bucles de simulación y dibujo recorren solo
+// lo que existe y los kernels SIMD leen x, y, vx, vy de forma contigua.
+// Cada entidad tiene además un slot estable y un handle generacional (ver SlotMap).
+class EntityStore {
+private:
+    SlotMap slots;
+
+    EntityStore(const EntityStore&) = delete;
+    EntityStore& operator=(const EntityStore&) = delete;
+public:
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    int* size;
+    int* type;
+    int* owner; // quién la creó (p. ej. el bot que disparó una bala), -1 si nadie
+    // Posición al empezar el tick, para interpolar al dibujar entre dos ticks
+    float* prevX;
+    float* prevY;
+    int count;
+
+    explicit EntityStore(int cap);
+    ~EntityStore();
+
+    int getCapacity() const { return slots.getCapacity(); }
+    bool full() const { return count == getCapacity(); }
+    // Añade una entidad al final y devuelve su índice, o -1 si no cabe
+    int spawn();
+    // Borra 'i' moviendo la última entidad a su hueco. Los slots y handles no cambian,
+    // solo el índice denso de la entidad movida.
+    void kill(int i);
+    void clear() { slots.clear(); count = 0; }
+    // Copia x, y en prevX, prevY para todas las entidades vivas
+    void savePositions();
+
+    // Slot estable de la entidad (sirve de clave en el broadphase)
+    int slot(int i) const { return slots.slotOf(i); }
+    int indexOfSlot(int s) const { return slots.indexOfSlot(s); }
+    EntityHandle handle(int i) const { return slots.handleOf(i); }
+    int find(EntityHandle h) const { return slots.find(h); }
+};
+
+// Mueve las entidades [begin, end) (p += v * scale) y las envuelve en [0, w] x [0, h] sin ramas.
+// Equivale a: x += vx * scale; if (x > w) x = 0; else if (x < 0) x = w; (igual en y)
+// Con scale = 1 el resultado es el mismo bit a bit que sumar v sin más.
+// Los trozos son independientes y se pueden repartir entre hilos.
+void IntegrateWrap(EntityStore& s, float w, float h, float scale, int begin, int end);
+
+// Mueve todas las entidades y marca en 'outside' (1 byte por entidad) las que salieron de [0, w] x [0, h]
+void IntegrateCull(EntityStore& s, float w, float h, float scale, unsigned char* outside);
+
+#endif
@@ -0,0 +1,131 @@
+#include "jobs.h"
+
+JobSystem::JobSystem(int workerThreads)
+    : threadTotal((workerThreads > 0 ? workerThreads : 0) + 1), queues(nullptr), workers(nullptr),
+      wakeGeneration(0), quit(false), steals(0), running(false) {
+    queues = new WorkQueue[threadTotal];
+    for (int q = 0; q < threadTotal; q++) {
+        queues[q].capacity = 64;
+        queues[q].jobs = new Job[queues[q].capacity];
+        queues[q].head = queues[q].tail = 0;
+    }
+    // El hilo 0 es siempre el que llama a parallelFor
+    if (threadTotal > 1) {
+        workers = new std::thread[threadTotal - 1];
+        for (int t = 1; t < threadTotal; t++) workers[t - 1] = std::thread(&JobSystem::workerLoop, this, t);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        quit = true;
+    }
+    wake.notify_all();
+    for (int t = 1; t < threadTotal; t++) workers[t - 1].join();
+    delete[] workers;
+    for (int q = 0; q < threadTotal; q++) delete[] queues[q].jobs;
+    delete[] queues;
+}
+
+int JobSystem::defaultWorkers() {
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 1 ? (int)cores - 1 : 0;
+}
+
+void JobSystem::push(int queue, const Job& job) {
+    WorkQueue& q = queues[queue];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.tail == q.capacity) {
+        // Compactar si el principio quedó libre por robos; si no, duplicar
+        int used = q.tail - q.head;
+        int newCap = used * 2 > q.capacity ? q.capacity * 2 : q.capacity;
+        Job* newJobs = newCap != q.capacity ? new Job[newCap] : q.jobs;
+        for (int i = 0; i < used; i++) newJobs[i] = q.jobs[q.head + i];
+        if (newJobs != q.jobs) delete[] q.jobs;
+        q.jobs = newJobs;
+        q.capacity = newCap;
+        q.head = 0;
+        q.tail = used;
+    }
+    q.jobs[q.tail++] = job;
+}
+
+bool JobSystem::popLocal(int queue, Job& job) {
+    WorkQueue& q = queues[queue];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.head == q.tail) return false;
+    job = q.jobs[--q.tail];
+    if (q.head == q.tail) q.head = q.tail = 0;
+    return true;
+}
+
+bool JobSystem::steal(int thief, Job& job) {
+    for (int i = 1; i < threadTotal; i++) {
+        WorkQueue& q = queues[(thief + i) % threadTotal];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.head == q.tail) continue;
+        // Se roba el trozo más antiguo: suele ser el más alejado de lo que la víctima tiene en caché
+        job = q.jobs[q.head++];
+        if (q.head == q.tail) q.head = q.tail = 0;
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::findWork(int thread, Job& job) {
+    if (popLocal(thread, job)) return true;
+    if (steal(thread, job)) {
+        steals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::workerLoop(int thread) {
+    unsigned seen = 0;
+    for (;;) {
+        Job job;
+        while (findWork(thread, job)) {
+            job.run(job.ctx, job.begin, job.end, thread);
+            job.remaining->fetch_sub(1, std::memory_order_acq_rel);
+        }
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait(guard, [&] { return quit || wakeGeneration != seen; });
+        if (quit) return;
+        seen = wakeGeneration;
+    }
+}
+
+void JobSystem::dispatch(void (*run)(void*, int, int, int), void* ctx, int count, int grain) {
+    std::atomic<int> remaining(0);
+    int chunks = (count + grain - 1) / grain;
+    remaining.store(chunks, std::memory_order_relaxed);
+
+    // Reparto inicial en bloques contiguos por hilo; el robo corrige los desequilibrios
+    for (int c = 0; c < chunks; c++) {
+        Job job;
+        job.run = run;
+        job.ctx = ctx;
+        job.begin = c * grain;
+        job.end = job.begin + grain < count ? job.begin + grain : count;
+        job.remaining = &remaining;
+        push((int)((long long)c * threadTotal / chunks), job);
+    }
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        wakeGeneration++;
+    }
+    wake.notify_all();
+
+    // El hilo que llama ayuda hasta que no queda nada y luego espera a los trozos en curso
+    Job job;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (findWork(0, job)) {
+            job.run(job.ctx, job.begin, job.end, 0);
+            job.remaining->fetch_sub(1, std::memory_order_acq_rel);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
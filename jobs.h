@@ -0,0 +1,92 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Planificador de trabajos con robo de tareas. Cada hilo tiene su propia cola: saca trabajo
+// de su final y, cuando se queda sin nada, roba del principio de las colas de los demás.
+// El hilo que llama a parallelFor también trabaja hasta que terminan todos los trozos.
+class JobSystem {
+private:
+    struct Job {
+        void (*run)(void* ctx, int begin, int end, int thread);
+        void* ctx;
+        int begin, end;
+        std::atomic<int>* remaining;
+    };
+
+    // Cola de un hilo; el mutex solo se disputa cuando otro hilo viene a robar
+    struct WorkQueue {
+        std::mutex lock;
+        Job* jobs;
+        int head, tail, capacity;
+    };
+
+    int threadTotal;           // trabajadores + el hilo que llama
+    WorkQueue* queues;
+    std::thread* workers;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    unsigned wakeGeneration;
+    bool quit;
+    std::atomic<long long> steals;
+    std::atomic<bool> running;  // hay un parallelFor en curso (ver parallelFor)
+
+    void push(int queue, const Job& job);
+    bool popLocal(int queue, Job& job);
+    bool steal(int thief, Job& job);
+    bool findWork(int thread, Job& job);
+    void workerLoop(int thread);
+    void dispatch(void (*run)(void*, int, int, int), void* ctx, int count, int grain);
+
+    void enterFor() {
+        bool nested = running.exchange(true, std::memory_order_acquire);
+        assert(!nested && "parallelFor anidado o desde dos hilos a la vez");
+        (void)nested;
+    }
+    void leaveFor() { running.store(false, std::memory_order_release); }
+
+    template <typename Fn>
+    static void trampoline(void* ctx, int begin, int end, int thread) {
+        (*(Fn*)ctx)(begin, end, thread);
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+public:
+    // 'workerThreads' hilos además del que llama; 0 ejecuta todo en el hilo actual
+    explicit JobSystem(int workerThreads);
+    ~JobSystem();
+
+    // Hilos que pueden ejecutar trabajos a la vez (incluido el que llama)
+    int threadCount() const { return threadTotal; }
+    long long stealCount() const { return steals.load(std::memory_order_relaxed); }
+
+    // Divide [0, count) en trozos de 'grain' y llama fn(begin, end, thread) para cada uno.
+    // 'thread' está en [0, threadCount()) y sirve para elegir buffers por hilo.
+    // Vuelve cuando todos los trozos terminaron.
+    // Solo desde un hilo, no anidado: el que llama es siempre el hilo 0 y comparte su cola y sus
+    // buffers por hilo, así que un parallelFor dentro de un trabajo o desde dos hilos a la vez
+    // los pisaría. Un assert lo detecta en las compilaciones de depuración.
+    template <typename Fn>
+    void parallelFor(int count, int grain, Fn fn) {
+        if (count <= 0) return;
+        if (grain < 1) grain = 1;
+        enterFor();
+        if (threadTotal == 1 || count <= grain) {
+            for (int b = 0; b < count; b += grain) fn(b, b + grain < count ? b + grain : count, 0);
+        } else {
+            dispatch(&trampoline<Fn>, &fn, count, grain);
+        }
+        leaveFor();
+    }
+
+    // Hilos de trabajo recomendados para esta máquina (núcleos - 1)
+    static int defaultWorkers();
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "linearquadtree.h"
+
+#include <cmath>
+
+static const int LINEAR_CELLS = 1 << LINEAR_LEVELS;
+// Dos pasadas de radix sort de LINEAR_LEVELS bits cubren los 2 * LINEAR_LEVELS bits del código
+static const int RADIX_BUCKETS = 1 << LINEAR_LEVELS;
+
+// Separa los bits bajos de v con un cero entre cada dos (0b1011 -> 0b1000101)
+static inline unsigned spreadBits(unsigned v) {
+    v &= 0xFFFF;
+    v = (v | (v << 8)) & 0x00FF00FFu;
+    v = (v | (v << 4)) & 0x0F0F0F0Fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v;
+}
+
+static inline unsigned mortonCode(int x, int y) {
+    return spreadBits((unsigned)x) | (spreadBits((unsigned)y) << 1);
+}
+
+LinearQuadTree::LinearQuadTree(const CustomRectangle& b)
+    : rootBoundary(b), originX(b.x - b.width/2), originY(b.y - b.height/2),
+      cellW(b.width / LINEAR_CELLS), cellH(b.height / LINEAR_CELLS), maxHalfW(0), maxHalfH(0),
+      objects(nullptr), objectHandles(nullptr), objectCount(0), objectCapacity(0),
+      codes(nullptr), order(nullptr), orderTmp(nullptr),
+      sortedCodes(nullptr), sortedMinX(nullptr), sortedMinY(nullptr), sortedMaxX(nullptr), sortedMaxY(nullptr),
+      sortedItems(nullptr), sortedCapacity(0), dirty(false),
+      scratch(nullptr), scratchCount(0), scratchCapacity(0), allocations(0) {}
+
+LinearQuadTree::~LinearQuadTree() {
+    delete[] objects;
+    delete[] objectHandles;
+    delete[] codes;
+    delete[] order;
+    delete[] orderTmp;
+    delete[] sortedCodes;
+    delete[] sortedMinX;
+    delete[] sortedMinY;
+    delete[] sortedMaxX;
+    delete[] sortedMaxY;
+    delete[] sortedItems;
+    delete[] scratch;
+}
+
+template <typename T>
+void LinearQuadTree::reserveArray(T*& data, int used, int newCap) {
+    T* newData = new T[newCap];
+    for (int i = 0; i < used; i++) newData[i] = data[i];
+    delete[] data;
+    data = newData;
+    allocations++;
+}
+
+// Las celdas del borde se extienden hasta el infinito: un centro fuera de la raíz (objeto que
+// solo la roza) cae en la celda más cercana y la consulta, acotada igual, lo sigue encontrando
+int LinearQuadTree::cellX(float x) const {
+    float c = floorf((x - originX) / cellW);
+    return c < 0 ? 0 : (c >= LINEAR_CELLS ? LINEAR_CELLS - 1 : (int)c);
+}
+
+int LinearQuadTree::cellY(float y) const {
+    float c = floorf((y - originY) / cellH);
+    return c < 0 ? 0 : (c >= LINEAR_CELLS ? LINEAR_CELLS - 1 : (int)c);
+}
+
+bool LinearQuadTree::insert(const GameObject& object, int handle) {
+    if (!rootBoundary.intersects(object.getBounds())) return false;
+    if (objectCount == objectCapacity) {
+        int newCap = objectCapacity > 0 ? objectCapacity * 2 : 64;
+        reserveArray(objects, objectCount, newCap);
+        reserveArray(objectHandles, objectCount, newCap);
+        objectCapacity = newCap;
+    }
+    objects[objectCount] = object;
+    objectHandles[objectCount] = handle;
+    objectCount++;
+    if (object.width / 2 > maxHalfW) maxHalfW = object.width / 2;
+    if (object.height / 2 > maxHalfH) maxHalfH = object.height / 2;
+    dirty = true;
+    return true;
+}
+
+void LinearQuadTree::build() {
+    dirty = false;
+    int n = objectCount;
+    if (n > sortedCapacity) {
+        int newCap = sortedCapacity > 0 ? sortedCapacity : 64;
+        while (newCap < n) newCap *= 2;
+        // Se rellenan enteros en cada build: no hace falta copiar lo anterior
+        reserveArray(codes, 0, newCap);
+        reserveArray(order, 0, newCap);
+        reserveArray(orderTmp, 0, newCap);
+        reserveArray(sortedCodes, 0, newCap);
+        reserveArray(sortedMinX, 0, newCap);
+        reserveArray(sortedMinY, 0, newCap);
+        reserveArray(sortedMaxX, 0, newCap);
+        reserveArray(sortedMaxY, 0, newCap);
+        reserveArray(sortedItems, 0, newCap);
+        sortedCapacity = newCap;
+    }
+
+    for (int i = 0; i < n; i++) {
+        codes[i] = mortonCode(cellX(objects[i].position.x), cellY(objects[i].position.y));
+        order[i] = i;
+    }
+
+    // Radix sort LSD estable: a igual código se conserva el orden de inserción
+    int count[RADIX_BUCKETS];
+    int* src = order;
+    int* dst = orderTmp;
+    for (int pass = 0; pass < 2; pass++) {
+        int shift = pass * LINEAR_LEVELS;
+        for (int b = 0; b < RADIX_BUCKETS; b++) count[b] = 0;
+        for (int i = 0; i < n; i++) count[(codes[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+        int sum = 0;
+        for (int b = 0; b < RADIX_BUCKETS; b++) {
+            int c = count[b];
+            count[b] = sum;
+            sum += c;
+        }
+        for (int i = 0; i < n; i++) {
+            int obj = src[i];
+            dst[count[(codes[obj] >> shift) & (RADIX_BUCKETS - 1)]++] = obj;
+        }
+        int* t = src; src = dst; dst = t;
+    }
+    // Tras un número par de pasadas el resultado vuelve a estar en 'order' (== src)
+    for (int i = 0; i < n; i++) {
+        int obj = src[i];
+        const GameObject& o = objects[obj];
+        sortedCodes[i] = codes[obj];
+        sortedMinX[i] = o.position.x - o.width/2;
+        sortedMinY[i] = o.position.y - o.height/2;
+        sortedMaxX[i] = o.position.x + o.width/2;
+        sortedMaxY[i] = o.position.y + o.height/2;
+        sortedItems[i] = obj;
+    }
+}
+
+void LinearQuadTree::clear() {
+    objectCount = 0;
+    maxHalfW = maxHalfH = 0;
+    dirty = false;
+}
+
+HandleSpan LinearQuadTree::queryHandles(const CustomRectangle& range) {
+    scratchCount = 0;
+    visit(range, [this](const GameObject&, int handle) {
+        if (scratchCount == scratchCapacity) {
+            int newCap = scratchCapacity > 0 ? scratchCapacity * 2 : 64;
+            reserveArray(scratch, scratchCount, newCap);
+            scratchCapacity = newCap;
+        }
+        scratch[scratchCount++] = handle;
+        return true;
+    });
+    HandleSpan span = { scratch, scratchCount };
+    return span;
+}
+
+void LinearQuadTree::query(const CustomRectangle& range, GameObjectList& foundList) {
+    visit(range, [&foundList](const GameObject& obj, int) {
+        foundList.add(obj);
+        return true;
+    });
+}
+
+long long LinearQuadTree::memoryBytes() const {
+    long long bytes = (long long)objectCapacity * (sizeof(GameObject) + sizeof(int));
+    bytes += (long long)sortedCapacity * (3 * sizeof(int) + sizeof(unsigned) * 2 + 4 * sizeof(float));
+    bytes += (long long)scratchCapacity * sizeof(int);
+    return bytes;
+}
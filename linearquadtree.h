@@ -0,0 +1,132 @@
+#ifndef LINEARQUADTREE_H
+#define LINEARQUADTREE_H
+
+#include "quadtree.h"
+
+// QuadTree lineal: los objetos se ordenan por el código Morton (orden Z) de su centro en una
+// rejilla de 2^LINEAR_LEVELS celdas por lado, y cada nodo del árbol es implícito: el tramo
+// contiguo del arreglo ordenado cuyos códigos empiezan por el prefijo del nodo. No hay nodos
+// guardados ni copias por frontera (cada objeto está una vez); una consulta baja por los
+// prefijos acotando el tramo con búsquedas binarias y recorre seguidos los objetos de cada hoja.
+// Como los objetos se ordenan por su centro, la consulta se amplía con la mayor semiextensión
+// insertada y luego se prueba la caja exacta: mismos resultados que QuadTree::visit dentro de
+// la raíz. Fuera de ella el lineal también encuentra los objetos que sobresalen del borde.
+const int LINEAR_LEVELS = 10;
+// Los tramos con pocos objetos se recorren enteros: más barato que seguir partiéndolos
+const int LINEAR_LEAF_SCAN = 16;
+
+class LinearQuadTree {
+private:
+    CustomRectangle rootBoundary;
+    float originX, originY;
+    float cellW, cellH;       // tamaño de celda de la rejilla Morton
+    float maxHalfW, maxHalfH; // mayores semiextensiones insertadas desde el último clear()
+
+    // Objetos en orden de inserción; build() los copia ordenados a los arreglos sorted*
+    GameObject* objects;
+    int* objectHandles;
+    int objectCount, objectCapacity;
+    unsigned* codes;          // código de cada objeto (orden de inserción)
+    int* order;               // índices ordenados por código; 'orderTmp' es el buffer del radix sort
+    int* orderTmp;
+    unsigned* sortedCodes;
+    float* sortedMinX;
+    float* sortedMinY;
+    float* sortedMaxX;
+    float* sortedMaxY;
+    int* sortedItems;         // índice del objeto en 'objects'
+    int sortedCapacity;
+    bool dirty;
+    int* scratch;             // resultados de queryHandles
+    int scratchCount, scratchCapacity;
+    long long allocations;
+
+    template <typename T> void reserveArray(T*& data, int used, int newCap);
+    int cellX(float x) const;
+    int cellY(float y) const;
+    // Tramo [begin, end) de objetos cuyo código empieza en 'code' y tiene span = size * size celdas
+    template <typename Visitor>
+    bool visitAt(int cx, int cy, int size, unsigned code, int begin, int end,
+                 int qx0, int qy0, int qx1, int qy1, const CustomRectangle& range, Visitor& fn) const;
+
+    LinearQuadTree(const LinearQuadTree&) = delete;
+    LinearQuadTree& operator=(const LinearQuadTree&) = delete;
+public:
+    explicit LinearQuadTree(const CustomRectangle& b);
+    ~LinearQuadTree();
+    // Igual que QuadTree::insert: false si el objeto queda fuera de la raíz. El árbol se
+    // reordena en la siguiente consulta (o con build()).
+    bool insert(const GameObject& object, int handle = -1);
+    // Códigos Morton, radix sort y copia ordenada en SoA
+    void build();
+    void clear();
+
+    // Llama fn(const GameObject&, int handle) una vez por objeto que intersecta 'range'.
+    // El visitante devuelve false para detener la búsqueda. El orden es el de los códigos.
+    template <typename Visitor>
+    void visit(const CustomRectangle& range, Visitor fn);
+    // Handles de los objetos que intersectan 'range' (sin duplicados)
+    HandleSpan queryHandles(const CustomRectangle& range);
+    // Copia cada coincidencia, una vez por objeto
+    void query(const CustomRectangle& range, GameObjectList& foundList);
+
+    int objectTotal() const { return objectCount; }
+    long long memoryBytes() const;
+    long long allocationCount() const { return allocations; }
+};
+
+template <typename Visitor>
+bool LinearQuadTree::visitAt(int cx, int cy, int size, unsigned code, int begin, int end,
+                             int qx0, int qy0, int qx1, int qy1, const CustomRectangle& range, Visitor& fn) const {
+    if (begin == end) return true;
+    if (cx > qx1 || cx + size - 1 < qx0 || cy > qy1 || cy + size - 1 < qy0) return true;
+
+    bool inside = cx >= qx0 && cx + size - 1 <= qx1 && cy >= qy0 && cy + size - 1 <= qy1;
+    if (inside || size == 1 || end - begin <= LINEAR_LEAF_SCAN) {
+        float rx0 = range.x - range.width/2, rx1 = range.x + range.width/2;
+        float ry0 = range.y - range.height/2, ry1 = range.y + range.height/2;
+        for (int i = begin; i < end; i++) {
+            // Misma prueba que CustomRectangle::intersects
+            if (sortedMinX[i] > rx1 || sortedMaxX[i] < rx0 || sortedMinY[i] > ry1 || sortedMaxY[i] < ry0) continue;
+            int obj = sortedItems[i];
+            if (!fn(objects[obj], objectHandles[obj])) return false;
+        }
+        return true;
+    }
+
+    // Los cuatro hijos son tramos seguidos del padre (orden Z: x en el bit bajo de cada par)
+    int half = size / 2;
+    unsigned span = (unsigned)half * (unsigned)half;
+    int split[5];
+    split[0] = begin;
+    split[4] = end;
+    for (int q = 1; q < 4; q++) {
+        unsigned key = code + q * span;
+        int lo = split[q - 1], hi = end;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (sortedCodes[mid] < key) lo = mid + 1; else hi = mid;
+        }
+        split[q] = lo;
+    }
+    for (int q = 0; q < 4; q++) {
+        if (!visitAt(cx + (q & 1) * half, cy + (q >> 1) * half, half, code + q * span,
+                     split[q], split[q + 1], qx0, qy0, qx1, qy1, range, fn)) return false;
+    }
+    return true;
+}
+
+template <typename Visitor>
+void LinearQuadTree::visit(const CustomRectangle& range, Visitor fn) {
+    if (dirty) build();
+    if (objectCount == 0) return;
+    // Celdas donde puede estar el centro de algo que toque 'range', con una de margen para
+    // que el redondeo en los bordes de celda no deje fuera a nadie (cellX ya acota el resultado)
+    int qx0 = cellX(range.x - range.width/2 - maxHalfW - cellW);
+    int qx1 = cellX(range.x + range.width/2 + maxHalfW + cellW);
+    int qy0 = cellY(range.y - range.height/2 - maxHalfH - cellH);
+    int qy1 = cellY(range.y + range.height/2 + maxHalfH + cellH);
+    visitAt(0, 0, 1 << LINEAR_LEVELS, 0u, 0, objectCount, qx0, qy0, qx1, qy1, range, fn);
+}
+
+#endif
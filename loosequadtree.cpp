@@ -0,0 +1,244 @@
+#include "loosequadtree.h"
+
+static bool containsRect(const CustomRectangle& outer, const CustomRectangle& inner) {
+    return inner.x - inner.width/2 >= outer.x - outer.width/2 &&
+           inner.x + inner.width/2 <= outer.x + outer.width/2 &&
+           inner.y - inner.height/2 >= outer.y - outer.height/2 &&
+           inner.y + inner.height/2 <= outer.y + outer.height/2;
+}
+
+LooseQuadTree::LooseQuadTree(const CustomRectangle& b, int cap, int mD)
+    : rootBoundary(b), capacity(cap < 1 ? 1 : cap), maxDepth(mD),
+      nodes(nullptr), nodeCount(0), nodeCapacity(0), freeGroup(-1), freeGroups(0),
+      items(nullptr), itemNode(nullptr), itemPrev(nullptr), itemNext(nullptr), handleCapacity(0),
+      pendingMerge(nullptr), pendingCount(0), pendingCapacity(0),
+      scratch(nullptr), scratchCount(0), scratchCapacity(0),
+      allocations(0), relocations(0) {
+    clear();
+}
+
+LooseQuadTree::~LooseQuadTree() {
+    delete[] nodes;
+    delete[] items;
+    delete[] itemNode;
+    delete[] itemPrev;
+    delete[] itemNext;
+    delete[] pendingMerge;
+    delete[] scratch;
+}
+
+template <typename T>
+void LooseQuadTree::reserveArray(T*& data, int used, int newCap) {
+    T* newData = new T[newCap];
+    for (int i = 0; i < used; i++) newData[i] = data[i];
+    delete[] data;
+    data = newData;
+    allocations++;
+}
+
+void LooseQuadTree::reserveHandles(int handle) {
+    if (handle < handleCapacity) return;
+    int newCap = handleCapacity > 0 ? handleCapacity * 2 : 64;
+    while (newCap <= handle) newCap *= 2;
+    reserveArray(items, handleCapacity, newCap);
+    reserveArray(itemNode, handleCapacity, newCap);
+    reserveArray(itemPrev, handleCapacity, newCap);
+    reserveArray(itemNext, handleCapacity, newCap);
+    for (int h = handleCapacity; h < newCap; h++) itemNode[h] = -1;
+    handleCapacity = newCap;
+}
+
+int LooseQuadTree::allocGroup() {
+    if (freeGroup != -1) {
+        int g = freeGroup;
+        freeGroup = nodes[g].head;
+        freeGroups--;
+        return g;
+    }
+    if (nodeCount + 4 > nodeCapacity) {
+        int newCap = nodeCapacity > 0 ? nodeCapacity * 2 : 64;
+        reserveArray(nodes, nodeCount, newCap);
+        nodeCapacity = newCap;
+    }
+    int g = nodeCount;
+    nodeCount += 4;
+    return g;
+}
+
+void LooseQuadTree::initNode(int node, const CustomRectangle& b, int depth, int parent) {
+    Node& n = nodes[node];
+    n.boundary = b;
+    n.loose = CustomRectangle(b.x, b.y, b.width * 2.0f, b.height * 2.0f);
+    n.depth = depth;
+    n.parent = parent;
+    n.firstChild = -1;
+    n.head = -1;
+    n.count = 0;
+    n.subtree = 0;
+}
+
+int LooseQuadTree::childFor(int node, const CustomRectangle& bounds) const {
+    const Node& n = nodes[node];
+    // El centro decide el cuadrante; la celda ampliada del hijo debe contenerlo entero
+    int c = n.firstChild + (bounds.y >= n.boundary.y ? 2 : 0) + (bounds.x >= n.boundary.x ? 1 : 0);
+    return containsRect(nodes[c].loose, bounds) ? c : -1;
+}
+
+void LooseQuadTree::link(int node, int handle) {
+    itemNode[handle] = node;
+    itemPrev[handle] = -1;
+    itemNext[handle] = nodes[node].head;
+    if (nodes[node].head != -1) itemPrev[nodes[node].head] = handle;
+    nodes[node].head = handle;
+    nodes[node].count++;
+    for (int n = node; n != -1; n = nodes[n].parent) nodes[n].subtree++;
+}
+
+void LooseQuadTree::unlink(int handle) {
+    int node = itemNode[handle];
+    if (itemPrev[handle] != -1) itemNext[itemPrev[handle]] = itemNext[handle];
+    else nodes[node].head = itemNext[handle];
+    if (itemNext[handle] != -1) itemPrev[itemNext[handle]] = itemPrev[handle];
+    nodes[node].count--;
+    itemNode[handle] = -1;
+
+    for (int n = node; n != -1; n = nodes[n].parent) {
+        if (--nodes[n].subtree == 0 && nodes[n].firstChild != -1) {
+            // La fusión se hace en maintain() para no rehacer nodos que se vacían un solo frame
+            if (pendingCount == pendingCapacity) {
+                int newCap = pendingCapacity > 0 ? pendingCapacity * 2 : 64;
+                reserveArray(pendingMerge, pendingCount, newCap);
+                pendingCapacity = newCap;
+            }
+            pendingMerge[pendingCount++] = n;
+        }
+    }
+}
+
+void LooseQuadTree::place(int node, int handle) {
+    CustomRectangle bounds = items[handle].getBounds();
+    while (nodes[node].firstChild != -1) {
+        int c = childFor(node, bounds);
+        if (c == -1) break;
+        node = c;
+    }
+    link(node, handle);
+    if (nodes[node].firstChild == -1 && nodes[node].count > capacity && nodes[node].depth < maxDepth) split(node);
+}
+
+void LooseQuadTree::split(int node) {
+    int first = allocGroup();
+    CustomRectangle bnd = nodes[node].boundary;
+    float x = bnd.x;
+    float y = bnd.y;
+    float w = bnd.width / 2.0f;
+    float h = bnd.height / 2.0f;
+    int depth = nodes[node].depth + 1;
+    initNode(first + 0, CustomRectangle(x - w/2, y - h/2, w, h), depth, node);
+    initNode(first + 1, CustomRectangle(x + w/2, y - h/2, w, h), depth, node);
+    initNode(first + 2, CustomRectangle(x - w/2, y + h/2, w, h), depth, node);
+    initNode(first + 3, CustomRectangle(x + w/2, y + h/2, w, h), depth, node);
+    nodes[node].firstChild = first;
+
+    // Bajar a los hijos los objetos que caben; los grandes se quedan en este nodo
+    int h0 = nodes[node].head;
+    nodes[node].head = -1;
+    nodes[node].count = 0;
+    while (h0 != -1) {
+        int next = itemNext[h0];
+        int c = childFor(node, items[h0].getBounds());
+        int target = (c != -1) ? c : node;
+        itemNode[h0] = target;
+        itemPrev[h0] = -1;
+        itemNext[h0] = nodes[target].head;
+        if (nodes[target].head != -1) itemPrev[nodes[target].head] = h0;
+        nodes[target].head = h0;
+        nodes[target].count++;
+        if (target != node) nodes[target].subtree++;
+        h0 = next;
+    }
+
+    for (int q = 0; q < 4; q++) {
+        if (nodes[first + q].count > capacity && depth < maxDepth) split(first + q);
+    }
+}
+
+void LooseQuadTree::collapse(int node) {
+    int first = nodes[node].firstChild;
+    if (first == -1) return;
+    for (int q = 0; q < 4; q++) {
+        collapse(first + q);
+        nodes[first + q].depth = -1;
+    }
+    nodes[first].head = freeGroup;
+    freeGroup = first;
+    freeGroups++;
+    nodes[node].firstChild = -1;
+}
+
+void LooseQuadTree::insert(const GameObject& object, int handle) {
+    if (handle < 0) return;
+    reserveHandles(handle);
+    if (itemNode[handle] != -1) unlink(handle);
+    items[handle] = object;
+    place(0, handle);
+}
+
+void LooseQuadTree::update(int handle, const CustomRectangle& newBounds) {
+    if (!contains(handle)) return;
+    GameObject& obj = items[handle];
+    obj.position = Point(newBounds.x, newBounds.y);
+    obj.width = newBounds.width;
+    obj.height = newBounds.height;
+
+    int node = itemNode[handle];
+    bool stays = (node == 0 || containsRect(nodes[node].loose, newBounds));
+    // Si el nodo ya se dividió y ahora cabe en un hijo, también conviene bajarlo
+    if (stays && (nodes[node].firstChild == -1 || childFor(node, newBounds) == -1)) return;
+
+    relocations++;
+    unlink(handle);
+    int n = node;
+    while (n != 0 && !containsRect(nodes[n].loose, newBounds)) n = nodes[n].parent;
+    place(n, handle);
+}
+
+void LooseQuadTree::remove(int handle) {
+    if (contains(handle)) unlink(handle);
+}
+
+void LooseQuadTree::maintain() {
+    for (int i = 0; i < pendingCount; i++) {
+        int n = pendingMerge[i];
+        // Un nodo pudo liberarse al fusionar a su padre (depth -1) o volver a llenarse
+        if (nodes[n].depth >= 0 && nodes[n].subtree == 0) collapse(n);
+    }
+    pendingCount = 0;
+}
+
+HandleSpan LooseQuadTree::queryHandles(const CustomRectangle& range) {
+    scratchCount = 0;
+    visit(range, [this](const GameObject&, int handle) {
+        if (scratchCount == scratchCapacity) {
+            int newCap = scratchCapacity > 0 ? scratchCapacity * 2 : 64;
+            reserveArray(scratch, scratchCount, newCap);
+            scratchCapacity = newCap;
+        }
+        scratch[scratchCount++] = handle;
+        return true;
+    });
+    HandleSpan span = { scratch, scratchCount };
+    return span;
+}
+
+void LooseQuadTree::clear() {
+    nodeCount = 0;
+    freeGroup = -1;
+    freeGroups = 0;
+    pendingCount = 0;
+    for (int h = 0; h < handleCapacity; h++) itemNode[h] = -1;
+    // La raíz ocupa el primer grupo; sus otros tres nodos no se usan
+    int root = allocGroup();
+    initNode(root, rootBoundary, 0, -1);
+    for (int q = 1; q < 4; q++) nodes[root + q].depth = -1;
+}
@@ -0,0 +1,220 @@
+#ifndef LOOSEQUADTREE_H
+#define LOOSEQUADTREE_H
+
+#include "broadphase.h"
+
+// QuadTree "suelto": cada nodo acepta objetos dentro de su celda ampliada al doble,
+// así cada objeto vive en un único nodo y se puede mover o borrar sin reconstruir el árbol.
+class LooseQuadTree : public Broadphase {
+private:
+    struct Node {
+        CustomRectangle boundary; // celda exacta
+        CustomRectangle loose;    // celda ampliada (2x) usada para contener y consultar
+        int depth;
+        int parent;
+        int firstChild;  // -1 si es hoja; hijos contiguos nw, ne, sw, se
+        int head;        // primer handle de la lista de objetos del nodo
+        int count;       // objetos guardados en este nodo
+        int subtree;     // objetos en este nodo y sus descendientes
+    };
+
+    CustomRectangle rootBoundary;
+    int capacity;
+    int maxDepth;
+
+    Node* nodes;
+    int nodeCount, nodeCapacity;
+    int freeGroup;            // grupos de 4 hijos liberados por fusiones
+    int freeGroups;
+
+    // Datos por handle (el índice que usa el llamador)
+    GameObject* items;
+    int* itemNode;            // nodo que contiene el handle, -1 si no está en el árbol
+    int* itemPrev;
+    int* itemNext;
+    int handleCapacity;
+
+    int* pendingMerge;        // nodos que se quedaron vacíos y esperan fusión
+    int pendingCount, pendingCapacity;
+    int* scratch;
+    int scratchCount, scratchCapacity;
+    long long allocations;
+    long long relocations;
+
+    template <typename T> void reserveArray(T*& data, int used, int newCap);
+    void reserveHandles(int handle);
+    int allocGroup();
+    void initNode(int node, const CustomRectangle& b, int depth, int parent);
+    int childFor(int node, const CustomRectangle& bounds) const;
+    void link(int node, int handle);
+    void unlink(int handle);
+    void place(int node, int handle);
+    void split(int node);
+    void collapse(int node);
+
+    // 'tested' cuenta los objetos comparados con el rango (para el perfilador)
+    template <typename Visitor>
+    bool visitAt(int node, const CustomRectangle& range, Visitor& fn, int& tested) const {
+        const Node& n = nodes[node];
+        if (n.subtree == 0 || !n.loose.intersects(range)) return true;
+
+        for (int h = n.head; h != -1; h = itemNext[h]) {
+            tested++;
+            if (range.intersects(items[h].getBounds()) && !fn(items[h], h)) return false;
+        }
+        if (n.firstChild != -1) {
+            for (int q = 0; q < 4; q++) {
+                if (!visitAt(n.firstChild + q, range, fn, tested)) return false;
+            }
+        }
+        return true;
+    }
+
+    // Como QuadTree::sweepAt pero con las celdas ampliadas; los objetos de un nodo interior se
+    // prueban antes que sus hijos
+    template <typename Filter>
+    void sweepAt(int node, const Point& from, const Point& delta, float hx, float hy, Filter& accept,
+                 int& best, float& bestToi, int& tested) const {
+        const Node& n = nodes[node];
+        float t;
+        for (int h = n.head; h != -1; h = itemNext[h]) {
+            tested++;
+            // A igual tiempo, el handle menor (como en QuadTree y SpatialHash)
+            if (!SweptBoxToi(from, delta, hx, hy, items[h].getBounds(), t) || t > bestToi) continue;
+            if (t == bestToi && h >= best) continue;
+            if (!accept(items[h], h)) continue;
+            best = h;
+            bestToi = t;
+        }
+        if (n.firstChild == -1) return;
+        int order[4];
+        float enter[4];
+        int crossed = 0;
+        for (int q = 0; q < 4; q++) {
+            const Node& c = nodes[n.firstChild + q];
+            if (c.subtree == 0 || !SweptBoxToi(from, delta, hx, hy, c.loose, t) || t > bestToi) continue;
+            int k = crossed++;
+            while (k > 0 && enter[k - 1] > t) { enter[k] = enter[k - 1]; order[k] = order[k - 1]; k--; }
+            enter[k] = t;
+            order[k] = n.firstChild + q;
+        }
+        for (int k = 0; k < crossed && enter[k] <= bestToi; k++) {
+            sweepAt(order[k], from, delta, hx, hy, accept, best, bestToi, tested);
+        }
+    }
+
+    LooseQuadTree(const LooseQuadTree&) = delete;
+    LooseQuadTree& operator=(const LooseQuadTree&) = delete;
+public:
+    LooseQuadTree(const CustomRectangle& b, int cap = 16, int mD = 8);
+    ~LooseQuadTree();
+
+    // 'handle' identifica al objeto en las llamadas posteriores (p. ej. su slot en el arreglo)
+    void insert(const GameObject& object, int handle) override;
+    // Solo reubica el objeto si sale de la celda ampliada de su nodo
+    void update(int handle, const CustomRectangle& newBounds) override;
+    void remove(int handle) override;
+    bool contains(int handle) const { return handle >= 0 && handle < handleCapacity && itemNode[handle] != -1; }
+    // Fusiona los nodos que quedaron vacíos desde la última llamada
+    void maintain() override;
+    void clear() override;
+
+    // Cada objeto vive en un solo nodo, así que nunca se repite en una consulta.
+    // El visitante recibe (const GameObject&, int handle) y devuelve false para detenerse.
+    // No modifica el árbol: se puede recorrer desde varios hilos a la vez.
+    template <typename Visitor>
+    void visit(const CustomRectangle& range, Visitor fn) const {
+        int tested = 0;
+        visitAt(0, range, fn, tested);
+        PROFILE_COUNT(PROFILE_QUERIES, 1);
+        PROFILE_COUNT(PROFILE_TESTED, tested);
+    }
+    HandleSpan queryHandles(const CustomRectangle& range) override;
+
+    // Búsqueda best-first como QuadTree::nearest. Cada objeto cabe en la celda ampliada de su nodo,
+    // así que la distancia a esa celda acota la de todos los centros del subárbol.
+    template <typename Filter>
+    int nearest(const Point& p, int k, float maxRadius, Filter accept, NearestQueue& queue,
+                int* outHandles, float* outDist2 = nullptr) const {
+        if (k <= 0) return 0;
+        float maxD2 = maxRadius * maxRadius;
+        queue.clear();
+        // La raíz también guarda lo que no cabe en ninguna celda: se visita siempre
+        queue.push(0.0f, -1);
+
+        int found = 0;
+        int tested = 0;
+        float key;
+        int item;
+        while (found < k && queue.pop(key, item)) {
+            if (key > maxD2) break;
+            if (item >= 0) {
+                outHandles[found] = item;
+                if (outDist2) outDist2[found] = key;
+                found++;
+                continue;
+            }
+            const Node& n = nodes[-item - 1];
+            for (int h = n.head; h != -1; h = itemNext[h]) {
+                tested++;
+                if (!accept(items[h], h)) continue;
+                float dx = items[h].position.x - p.x, dy = items[h].position.y - p.y;
+                float d2 = dx*dx + dy*dy;
+                if (d2 <= maxD2) queue.push(d2, h);
+            }
+            if (n.firstChild != -1) {
+                for (int q = 0; q < 4; q++) {
+                    const Node& c = nodes[n.firstChild + q];
+                    if (c.subtree == 0) continue;
+                    float d2 = PointRectDistance2(p, c.loose);
+                    if (d2 <= maxD2) queue.push(d2, -(n.firstChild + q) - 1);
+                }
+            }
+        }
+        PROFILE_COUNT(PROFILE_QUERIES, 1);
+        PROFILE_COUNT(PROFILE_TESTED, tested);
+        return found;
+    }
+    int nearest(const Point& p, int k, float maxRadius, int type, NearestQueue& queue,
+                int* outHandles, float* outDist2 = nullptr) const override {
+        return nearest(p, k, maxRadius, [type](const GameObject& obj, int) {
+            return type == -1 || obj.type == type;
+        }, queue, outHandles, outDist2);
+    }
+    int findFirst(const CustomRectangle& range, int type) const override {
+        int found = -1;
+        visit(range, [&](const GameObject& obj, int h) {
+            if (type != -1 && obj.type != type) return true;
+            found = h;
+            return false;
+        });
+        return found;
+    }
+    // La raíz guarda también lo que no cabe en ninguna celda: se recorre siempre
+    template <typename Filter>
+    int sweep(const Point& from, const Point& to, float hx, float hy, Filter accept, float& toi) const {
+        Point delta(to.x - from.x, to.y - from.y);
+        int best = -1;
+        float bestToi = 2.0f;
+        int tested = 0;
+        if (nodes[0].subtree > 0) sweepAt(0, from, delta, hx, hy, accept, best, bestToi, tested);
+        PROFILE_COUNT(PROFILE_QUERIES, 1);
+        PROFILE_COUNT(PROFILE_TESTED, tested);
+        if (best != -1) toi = bestToi;
+        return best;
+    }
+    int sweepFirst(const Point& from, const Point& to, float hx, float hy, int type, float& toi) const override {
+        return sweep(from, to, hx, hy, [type](const GameObject& obj, int) {
+            return type == -1 || obj.type == type;
+        }, toi);
+    }
+    const GameObject& get(int handle) const override { return items[handle]; }
+    const char* name() const override { return "loose"; }
+
+    int nodeTotal() const override { return nodeCount - 3 - freeGroups * 4; }
+    int objectTotal() const { return nodes[0].subtree; }
+    long long allocationCount() const override { return allocations; }
+    long long relocationCount() const { return relocations; }
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "particles.h"
+
+#include <cmath>
+
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define PARTICLES_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define PARTICLES_SSE2 1
+#endif
+
+static const float PARTICLE_TWO_PI = 6.28318530717958647692f;
+
+ParticleSystem::ParticleSystem(int cap, float scale)
+    : capacity(64), head(0), tail(0), tickScale(scale), overwritten(0) {
+    while (capacity < cap) capacity <<= 1;
+    mask = (unsigned)capacity - 1;
+    debrisDrag = powf(0.97f, tickScale);
+    sparkDrag = powf(0.92f, tickScale);
+    x = new float[capacity];
+    y = new float[capacity];
+    prevX = new float[capacity];
+    prevY = new float[capacity];
+    vx = new float[capacity];
+    vy = new float[capacity];
+    drag = new float[capacity];
+    life = new float[capacity];
+    invLifetime = new float[capacity];
+    fade = new float[capacity];
+    size = new float[capacity];
+    kind = new unsigned char[capacity];
+}
+
+ParticleSystem::~ParticleSystem() {
+    delete[] x;
+    delete[] y;
+    delete[] prevX;
+    delete[] prevY;
+    delete[] vx;
+    delete[] vy;
+    delete[] drag;
+    delete[] life;
+    delete[] invLifetime;
+    delete[] fade;
+    delete[] size;
+    delete[] kind;
+}
+
+void ParticleSystem::reset(unsigned int seed) {
+    head = tail = 0;
+    overwritten = 0;
+    rng.seed(seed);
+}
+
+int ParticleSystem::spawn() {
+    // Lleno: la más antigua deja sitio
+    if ((int)(head - tail) == capacity) {
+        if (life[index(tail)] > 0) overwritten++;
+        tail++;
+    }
+    return index(head++);
+}
+
+void ParticleSystem::burst(float px, float py, float flashSize) {
+    int i = spawn();
+    x[i] = prevX[i] = px; y[i] = prevY[i] = py;
+    vx[i] = vy[i] = 0;
+    drag[i] = 1.0f;
+    life[i] = FLASH_SECONDS; invLifetime[i] = 1.0f / FLASH_SECONDS; fade[i] = 1.0f;
+    size[i] = flashSize;
+    kind[i] = PARTICLE_FLASH;
+
+    // Escombros lentos que duran y chispas rápidas que se apagan antes
+    for (int n = 0; n < DEBRIS_PER_HIT + SPARKS_PER_HIT; n++) {
+        bool debris = n < DEBRIS_PER_HIT;
+        float angle = random01() * PARTICLE_TWO_PI;
+        float speed = (debris ? 1.0f + 3.0f * random01() : 3.0f + 5.0f * random01()) * tickScale;
+        float lifetime = debris ? 0.6f + 0.6f * random01() : 0.25f + 0.35f * random01();
+        i = spawn();
+        x[i] = prevX[i] = px; y[i] = prevY[i] = py;
+        vx[i] = cosf(angle) * speed;
+        vy[i] = sinf(angle) * speed;
+        drag[i] = debris ? debrisDrag : sparkDrag;
+        life[i] = lifetime; invLifetime[i] = 1.0f / lifetime; fade[i] = 1.0f;
+        size[i] = debris ? 6.0f + 8.0f * random01() : 3.0f + 3.0f * random01();
+        kind[i] = (unsigned char)(debris ? PARTICLE_DEBRIS : PARTICLE_SPARK);
+    }
+}
+
+void ParticleSystem::updateSpan(int begin, int end, float dt) {
+    int i = begin;
+#if defined(PARTICLES_AVX)
+    __m256 vscale = _mm256_set1_ps(tickScale), vdt = _mm256_set1_ps(dt), zero = _mm256_setzero_ps();
+    for (; i + 8 <= end; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i);
+        __m256 pvx = _mm256_loadu_ps(vx + i), pvy = _mm256_loadu_ps(vy + i);
+        __m256 d = _mm256_loadu_ps(drag + i);
+        __m256 l = _mm256_sub_ps(_mm256_loadu_ps(life + i), vdt);
+        _mm256_storeu_ps(prevX + i, px);
+        _mm256_storeu_ps(prevY + i, py);
+        _mm256_storeu_ps(x + i, _mm256_add_ps(px, _mm256_mul_ps(pvx, vscale)));
+        _mm256_storeu_ps(y + i, _mm256_add_ps(py, _mm256_mul_ps(pvy, vscale)));
+        _mm256_storeu_ps(vx + i, _mm256_mul_ps(pvx, d));
+        _mm256_storeu_ps(vy + i, _mm256_mul_ps(pvy, d));
+        _mm256_storeu_ps(life + i, l);
+        _mm256_storeu_ps(fade + i, _mm256_mul_ps(_mm256_max_ps(l, zero), _mm256_loadu_ps(invLifetime + i)));
+    }
+#elif defined(PARTICLES_SSE2)
+    __m128 vscale = _mm_set1_ps(tickScale), vdt = _mm_set1_ps(dt), zero = _mm_setzero_ps();
+    for (; i + 4 <= end; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i);
+        __m128 pvx = _mm_loadu_ps(vx + i), pvy = _mm_loadu_ps(vy + i);
+        __m128 d = _mm_loadu_ps(drag + i);
+        __m128 l = _mm_sub_ps(_mm_loadu_ps(life + i), vdt);
+        _mm_storeu_ps(prevX + i, px);
+        _mm_storeu_ps(prevY + i, py);
+        _mm_storeu_ps(x + i, _mm_add_ps(px, _mm_mul_ps(pvx, vscale)));
+        _mm_storeu_ps(y + i, _mm_add_ps(py, _mm_mul_ps(pvy, vscale)));
+        _mm_storeu_ps(vx + i, _mm_mul_ps(pvx, d));
+        _mm_storeu_ps(vy + i, _mm_mul_ps(pvy, d));
+        _mm_storeu_ps(life + i, l);
+        _mm_storeu_ps(fade + i, _mm_mul_ps(_mm_max_ps(l, zero), _mm_loadu_ps(invLifetime + i)));
+    }
+#endif
+    // Resto (o todo, sin SIMD): las mismas operaciones en el mismo orden
+    for (; i < end; i++) {
+        prevX[i] = x[i];
+        prevY[i] = y[i];
+        x[i] += vx[i] * tickScale;
+        y[i] += vy[i] * tickScale;
+        vx[i] *= drag[i];
+        vy[i] *= drag[i];
+        life[i] -= dt;
+        fade[i] = (life[i] > 0 ? life[i] : 0.0f) * invLifetime[i];
+    }
+}
+
+void ParticleSystem::update(float dt, JobSystem* jobs) {
+    int n = window();
+    if (n == 0) return;
+    unsigned start = tail;
+    // Un trozo de la ventana puede cruzar el final del anillo: se parte en dos tramos seguidos
+    auto run = [this, start, dt](int begin, int end, int) {
+        int i = index(start + (unsigned)begin);
+        int len = end - begin;
+        int first = capacity - i < len ? capacity - i : len;
+        updateSpan(i, i + first, dt);
+        if (first < len) updateSpan(0, len - first, dt);
+    };
+    if (jobs) jobs->parallelFor(n, 8192, run);
+    else run(0, n, 0);
+    while (tail != head && life[index(tail)] <= 0) tail++;
+}
@@ -0,0 +1,72 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "rng.h"
+#include "jobs.h"
+
+// Partículas de los impactos (fogonazo, escombros y chispas) en un anillo de capacidad fija
+// en SoA. Cada partícula nueva se escribe en el siguiente hueco del anillo: alta en O(1) sin
+// buscar sitio, y si el anillo está lleno se pisa la más antigua en vez de perder la nueva.
+// Las vivas están en la ventana [tail, head) de contadores de alta (índice = contador & mask);
+// update() la recorre con SIMD y adelanta 'tail' sobre las que ya murieron al principio.
+// Son solo efectos: no entran en el checksum ni usan el generador de la simulación.
+
+enum ParticleKind { PARTICLE_FLASH = 0, PARTICLE_DEBRIS = 1, PARTICLE_SPARK = 2 };
+
+const int PARTICLE_CAPACITY = 1 << 17;
+// Cada impacto crea siempre las mismas: el coste no depende de cuántas haya ya
+const int DEBRIS_PER_HIT = 10;
+const int SPARKS_PER_HIT = 20;
+const int PARTICLES_PER_HIT = 1 + DEBRIS_PER_HIT + SPARKS_PER_HIT;
+// El flipbook de 6 cuadros que antes avanzaba cada 5 frames de dibujo a 60 Hz
+const float FLASH_SECONDS = 0.5f;
+
+class ParticleSystem {
+private:
+    int capacity;           // potencia de 2
+    unsigned mask;
+    unsigned head, tail;    // contadores de alta; pueden dar la vuelta, solo importa la resta
+    float tickScale;        // como en GameSim: velocidades por tick a SIM_BASE_TICK_RATE
+    float debrisDrag, sparkDrag; // rozamiento por tick ya escalado
+    long long overwritten;  // vivas pisadas por estar lleno el anillo
+    SimRng rng;
+
+    float random01() { return (float)(rng.next() >> 8) * (1.0f / 16777216.0f); }
+    int spawn();
+    void updateSpan(int begin, int end, float dt);
+
+    ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem& operator=(const ParticleSystem&) = delete;
+public:
+    float* x;
+    float* y;
+    float* prevX;           // al empezar el tick, para interpolar
+    float* prevY;
+    float* vx;
+    float* vy;
+    float* drag;            // factor de velocidad por tick
+    float* life;            // segundos que le quedan (<= 0: muerta)
+    float* invLifetime;
+    float* fade;            // life / duración en [0, 1]: 1 al nacer, 0 muerta
+    float* size;
+    unsigned char* kind;
+
+    // 'cap' se redondea a potencia de 2
+    ParticleSystem(int cap, float scale);
+    ~ParticleSystem();
+
+    void reset(unsigned int seed);
+    // Fogonazo de 'flashSize' px, escombros y chispas en (px, py): PARTICLES_PER_HIT altas
+    void burst(float px, float py, float flashSize);
+    // Mueve, frena y envejece la ventana entera; los trozos se reparten entre hilos
+    void update(float dt, JobSystem* jobs);
+
+    // Ventana viva: contador n en [first(), first() + window()), partícula n & mask
+    unsigned first() const { return tail; }
+    int window() const { return (int)(head - tail); }
+    int index(unsigned n) const { return (int)(n & mask); }
+    int getCapacity() const { return capacity; }
+    long long overwrittenCount() const { return overwritten; }
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+static long long NowNs() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler::Profiler() : written(0) {
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+        phaseNs[p].store(0, std::memory_order_relaxed);
+        phaseStart[p] = 0;
+    }
+    for (int c = 0; c < PROFILE_COUNTER_COUNT; c++) {
+        counters[c].store(0, std::memory_order_relaxed);
+        gauges[c] = 0;
+        isGauge[c] = false;
+    }
+}
+
+void Profiler::begin(ProfilePhase phase) {
+    phaseStart[phase] = NowNs();
+}
+
+void Profiler::end(ProfilePhase phase) {
+    addTime(phase, NowNs() - phaseStart[phase]);
+}
+
+void Profiler::endFrame() {
+    unsigned int w = written.load(std::memory_order_relaxed);
+    ProfileFrame& f = history[w & (PROFILE_HISTORY - 1)];
+    f.index = w;
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+        f.ms[p] = (float)(phaseNs[p].exchange(0, std::memory_order_relaxed) / 1.0e6);
+    }
+    for (int c = 0; c < PROFILE_COUNTER_COUNT; c++) {
+        long long n = counters[c].exchange(0, std::memory_order_relaxed);
+        f.counters[c] = isGauge[c] ? gauges[c] : n;
+    }
+    written.store(w + 1, std::memory_order_release);
+}
+
+int Profiler::recent(ProfileFrame* out, int maxFrames) const {
+    unsigned int w = written.load(std::memory_order_acquire);
+    // El hueco siguiente al último publicado es el que se está escribiendo
+    int n = (int)(w < (unsigned)(PROFILE_HISTORY - 1) ? w : (unsigned)(PROFILE_HISTORY - 1));
+    if (n > maxFrames) n = maxFrames;
+    unsigned int first = w - (unsigned)n;
+    for (int i = 0; i < n; i++) out[i] = history[(first + i) & (PROFILE_HISTORY - 1)];
+
+    // Si el escritor avanzó mientras tanto, los más viejos pueden estar pisados
+    unsigned int after = written.load(std::memory_order_acquire);
+    int skip = 0;
+    while (skip < n && (out[skip].index != first + skip || after - (first + skip) >= (unsigned)(PROFILE_HISTORY - 1))) skip++;
+    for (int i = skip; i < n; i++) out[i - skip] = out[i];
+    return n - skip;
+}
+
+void Profiler::summarize(ProfileSummary& out) const {
+    ProfileFrame frames[PROFILE_HISTORY];
+    float values[PROFILE_HISTORY];
+    int n = recent(frames, PROFILE_HISTORY);
+    out.frames = n;
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+        out.p50[p] = out.p95[p] = out.p99[p] = 0;
+        if (n == 0) continue;
+        for (int i = 0; i < n; i++) values[i] = frames[i].ms[p];
+        std::sort(values, values + n);
+        out.p50[p] = values[(n - 1) * 50 / 100];
+        out.p95[p] = values[(n - 1) * 95 / 100];
+        out.p99[p] = values[(n - 1) * 99 / 100];
+    }
+    for (int c = 0; c < PROFILE_COUNTER_COUNT; c++) out.last[c] = n > 0 ? frames[n - 1].counters[c] : 0;
+}
+
+bool Profiler::writeCsv(const char* path) const {
+    ProfileFrame frames[PROFILE_HISTORY];
+    int n = recent(frames, PROFILE_HISTORY);
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "frame");
+    for (int p = 0; p < PROFILE_PHASE_COUNT; p++) fprintf(f, ",%s_ms", phaseName(p));
+    for (int c = 0; c < PROFILE_COUNTER_COUNT; c++) fprintf(f, ",%s", counterName(c));
+    fprintf(f, "\n");
+    for (int i = 0; i < n; i++) {
+        fprintf(f, "%u", frames[i].index);
+        for (int p = 0; p < PROFILE_PHASE_COUNT; p++) fprintf(f, ",%.4f", frames[i].ms[p]);
+        for (int c = 0; c < PROFILE_COUNTER_COUNT; c++) fprintf(f, ",%lld", frames[i].counters[c]);
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    return true;
+}
+
+const char* Profiler::phaseName(int phase) {
+    static const char* names[PROFILE_PHASE_COUNT] = {
+        "frame", "step", "bots", "integrate", "broadphase", "bullets", "split", "collide", "particles", "stream", "draw"
+    };
+    return phase >= 0 && phase < PROFILE_PHASE_COUNT ? names[phase] : "?";
+}
+
+const char* Profiler::counterName(int counter) {
+    static const char* names[PROFILE_COUNTER_COUNT] = { "nodes", "queries", "tested", "allocs", "pairs", "particles", "dormant" };
+    return counter >= 0 && counter < PROFILE_COUNTER_COUNT ? names[counter] : "?";
+}
+
+Profiler& GlobalProfiler() {
+    static Profiler profiler;
+    return profiler;
+}
+
+ProfileScope::ProfileScope(ProfilePhase p) : phase(p), start(NowNs()) {}
+
+ProfileScope::~ProfileScope() {
+    GlobalProfiler().addTime(phase, NowNs() - start);
+}
@@ -0,0 +1,124 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+
+// Perfilador por fases del frame. Los PROFILE_SCOPE acumulan nanosegundos en la fase y los
+// PROFILE_COUNT suman contadores; PROFILE_END_FRAME guarda el frame en un anillo sin locks
+// que se puede leer (overlay, CSV) mientras el juego sigue escribiendo.
+// Sin ASTEROID_PROFILER las macros no generan código.
+
+enum ProfilePhase {
+    PROFILE_FRAME,      // UpdateDrawFrame sin la espera de EndDrawing
+    PROFILE_STEP,       // GameSim::step completo
+    PROFILE_BOTS,       // IA de los bots y fusión de sus disparos
+    PROFILE_INTEGRATE,  // movimiento de los asteroides
+    PROFILE_BROADPHASE, // updates y maintain (reconstrucción del quadtree)
+    PROFILE_BULLETS,    // consultas de las balas
+    PROFILE_SPLIT,      // aplicar impactos: romper asteroides y explosiones
+    PROFILE_COLLIDE,    // choques entre asteroides: autojoin y rebotes
+    PROFILE_PARTICLES,  // update de las partículas de los impactos
+    PROFILE_STREAM,     // sectores que despiertan y se duermen en un mundo grande
+    PROFILE_DRAW,       // dibujo
+    PROFILE_PHASE_COUNT
+};
+
+enum ProfileCounter {
+    PROFILE_NODES,      // nodos (o celdas) del broadphase al final del frame
+    PROFILE_QUERIES,    // consultas al broadphase
+    PROFILE_TESTED,     // candidatos que las consultas tuvieron que comprobar
+    PROFILE_ALLOCS,     // reservas de memoria acumuladas del broadphase
+    PROFILE_PAIRS,      // pares de asteroides que se solapan en el último step
+    PROFILE_PARTICLE_WINDOW, // partículas en la ventana del anillo al final del step
+    PROFILE_DORMANT,    // asteroides dormidos en sectores lejanos
+    PROFILE_COUNTER_COUNT
+};
+
+const int PROFILE_HISTORY = 512; // frames guardados; potencia de 2
+
+struct ProfileFrame {
+    unsigned int index;
+    float ms[PROFILE_PHASE_COUNT];
+    long long counters[PROFILE_COUNTER_COUNT];
+};
+
+// Percentiles de la ventana guardada, para el overlay
+struct ProfileSummary {
+    int frames;
+    float p50[PROFILE_PHASE_COUNT];
+    float p95[PROFILE_PHASE_COUNT];
+    float p99[PROFILE_PHASE_COUNT];
+    long long last[PROFILE_COUNTER_COUNT];
+};
+
+class Profiler {
+private:
+    // Frame en curso: se puede sumar desde cualquier hilo del JobSystem
+    std::atomic<long long> phaseNs[PROFILE_PHASE_COUNT];
+    std::atomic<long long> counters[PROFILE_COUNTER_COUNT];
+    long long phaseStart[PROFILE_PHASE_COUNT]; // para begin()/end()
+    long long gauges[PROFILE_COUNTER_COUNT];
+    bool isGauge[PROFILE_COUNTER_COUNT];
+    // Anillo de un solo escritor: el frame 'written' se publica después de copiarlo
+    ProfileFrame history[PROFILE_HISTORY];
+    std::atomic<unsigned int> written;
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+public:
+    Profiler();
+
+    void addTime(ProfilePhase phase, long long ns) { phaseNs[phase].fetch_add(ns, std::memory_order_relaxed); }
+    // Para fases que no coinciden con un ámbito. Solo desde el hilo principal.
+    void begin(ProfilePhase phase);
+    void end(ProfilePhase phase);
+    void count(ProfileCounter counter, long long n) { counters[counter].fetch_add(n, std::memory_order_relaxed); }
+    // Valor absoluto (p. ej. nodos): el frame guarda el último que se fijó. Solo desde el hilo principal.
+    void set(ProfileCounter counter, long long value) { gauges[counter] = value; isGauge[counter] = true; }
+    // Cierra el frame en curso y lo publica en el anillo. Solo desde el hilo principal.
+    void endFrame();
+
+    unsigned int frameCount() const { return written.load(std::memory_order_acquire); }
+    // Copia los últimos frames publicados (como mucho 'maxFrames', del más viejo al más nuevo).
+    // Puede llamarse desde otro hilo: descarta los frames que el escritor pisó durante la copia.
+    int recent(ProfileFrame* out, int maxFrames) const;
+    void summarize(ProfileSummary& out) const;
+    // Vuelca la ventana guardada en CSV (una fila por frame); false si no se pudo abrir
+    bool writeCsv(const char* path) const;
+
+    static const char* phaseName(int phase);
+    static const char* counterName(int counter);
+};
+
+Profiler& GlobalProfiler();
+
+// Mide desde su construcción hasta que sale de ámbito
+class ProfileScope {
+private:
+    ProfilePhase phase;
+    long long start;
+public:
+    explicit ProfileScope(ProfilePhase p);
+    ~ProfileScope();
+};
+
+#if defined(ASTEROID_PROFILER)
+    #define PROFILE_CONCAT_INNER(a, b) a##b
+    #define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+    #define PROFILE_SCOPE(phase) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(phase)
+    #define PROFILE_BEGIN(phase) GlobalProfiler().begin(phase)
+    #define PROFILE_END(phase) GlobalProfiler().end(phase)
+    #define PROFILE_COUNT(counter, n) GlobalProfiler().count(counter, n)
+    #define PROFILE_SET(counter, value) GlobalProfiler().set(counter, value)
+    #define PROFILE_END_FRAME() GlobalProfiler().endFrame()
+#else
+    // sizeof no evalúa la expresión; solo evita avisos por variables que quedan sin usar
+    #define PROFILE_SCOPE(phase) ((void)0)
+    #define PROFILE_BEGIN(phase) ((void)0)
+    #define PROFILE_END(phase) ((void)0)
+    #define PROFILE_COUNT(counter, n) ((void)sizeof(n))
+    #define PROFILE_SET(counter, value) ((void)sizeof(value))
+    #define PROFILE_END_FRAME() ((void)0)
+#endif
+
+#endif
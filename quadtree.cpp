@@ -1,81 +1,188 @@
 #include "quadtree.h"
 
-QuadTree::QuadTree(const CustomRectangle& b, int cap, int mD, int d)
-    : boundary(b), capacity(cap), maxDepth(mD), currentDepth(d), objects(cap), divided(false),
-      nw(nullptr), ne(nullptr), sw(nullptr), se(nullptr) {}
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define QUADTREE_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define QUADTREE_SSE2 1
+#endif
 
-QuadTree::~QuadTree() { clear(); }
+template <typename T>
+void QueryBatch::resizeArray(T*& data, int used, int newCap) {
+    T* newData = new T[newCap];
+    for (int i = 0; i < used; i++) newData[i] = data[i];
+    delete[] data;
+    data = newData;
+}
+
+QueryBatch::QueryBatch()
+    : handles(nullptr), handleCount(0), handleCapacity(0),
+      rangeStart(nullptr), rangeEnd(nullptr), rangeCount(0), rangeCapacity(0),
+      pairRange(nullptr), pairObject(nullptr), pairCount(0), pairCapacity(0),
+      active(nullptr), activeCapacity(0),
+      minX(nullptr), minY(nullptr), maxX(nullptr), maxY(nullptr) {}
 
-void QuadTree::subdivide() {
-    float x = boundary.x;
-    float y = boundary.y;
-    float w = boundary.width / 2.0f;
-    float h = boundary.height / 2.0f;
+QueryBatch::~QueryBatch() {
+    delete[] handles;
+    delete[] rangeStart;
+    delete[] rangeEnd;
+    delete[] pairRange;
+    delete[] pairObject;
+    delete[] active;
+    delete[] minX;
+    delete[] minY;
+    delete[] maxX;
+    delete[] maxY;
+}
 
-    // Los centros de los nuevos cuadrantes se calculan desplazando w/4 desde el centro original
-    nw = new QuadTree(CustomRectangle(x - w/2, y - h/2, w, h), capacity, maxDepth, currentDepth + 1);
-    ne = new QuadTree(CustomRectangle(x + w/2, y - h/2, w, h), capacity, maxDepth, currentDepth + 1);
-    sw = new QuadTree(CustomRectangle(x - w/2, y + h/2, w, h), capacity, maxDepth, currentDepth + 1);
-    se = new QuadTree(CustomRectangle(x + w/2, y + h/2, w, h), capacity, maxDepth, currentDepth + 1);
+void QueryBatch::reserveRanges(int need) {
+    if (need <= rangeCapacity) return;
+    int newCap = rangeCapacity > 0 ? rangeCapacity * 2 : 64;
+    while (newCap < need) newCap *= 2;
+    resizeArray(rangeStart, rangeCount, newCap);
+    resizeArray(rangeEnd, rangeCount, newCap);
+    resizeArray(minX, 0, newCap);
+    resizeArray(minY, 0, newCap);
+    resizeArray(maxX, 0, newCap);
+    resizeArray(maxY, 0, newCap);
+    rangeCapacity = newCap;
+}
 
-    divided = true;
+void QueryBatch::reserveHandles(int need) {
+    if (need <= handleCapacity) return;
+    int newCap = handleCapacity > 0 ? handleCapacity * 2 : 256;
+    while (newCap < need) newCap *= 2;
+    resizeArray(handles, handleCount, newCap);
+    handleCapacity = newCap;
+}
 
-    // RE-INSERTAR objetos del nodo actual en los hijos (Opcional pero recomendado para precisión)
-    for (int i = 0; i < objects.size(); i++) {
-        GameObject obj = objects.get(i);
-        nw->insert(obj);
-        ne->insert(obj);
-        sw->insert(obj);
-        se->insert(obj);
+void QueryBatch::prepare(int ranges, int activeNeed) {
+    clear();
+    reserveRanges(ranges);
+    if (activeNeed > activeCapacity) {
+        resizeArray(active, 0, activeNeed);
+        activeCapacity = activeNeed;
     }
-    objects.clear();
+    rangeCount = ranges;
+    pairCount = 0;
+}
+
+void QueryBatch::beginRange() {
+    reserveRanges(rangeCount + 1);
+    rangeStart[rangeCount] = handleCount;
+    rangeEnd[rangeCount] = handleCount;
+    rangeCount++;
 }
 
-bool QuadTree::insert(const GameObject& object) {
-    // Si el objeto no está ni siquiera cerca de este cuadrante, salir
-    if (!boundary.intersects(object.getBounds())) return false;
+void QueryBatch::add(int handle) {
+    reserveHandles(handleCount + 1);
+    handles[handleCount++] = handle;
+    rangeEnd[rangeCount - 1] = handleCount;
+}
 
-    if (!divided) {
-        // Si hay espacio o llegamos al límite de profundidad, guardar aquí
-        if (objects.size() < capacity || currentDepth >= maxDepth) {
-            objects.add(object);
-            return true;
+void QueryBatch::collectBlock(int r, const int* items, const float* ox0, const float* oy0,
+                              const float* ox1, const float* oy1, int used) {
+    float rx0 = minX[r], ry0 = minY[r], rx1 = maxX[r], ry1 = maxY[r];
+    int i = 0;
+#if defined(QUADTREE_AVX)
+    __m256 vrx0 = _mm256_set1_ps(rx0), vry0 = _mm256_set1_ps(ry0);
+    __m256 vrx1 = _mm256_set1_ps(rx1), vry1 = _mm256_set1_ps(ry1);
+    for (; i + 8 <= used; i += 8) {
+        __m256 m = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(ox0 + i), vrx1, _CMP_LE_OQ),
+                          _mm256_cmp_ps(_mm256_loadu_ps(ox1 + i), vrx0, _CMP_GE_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(oy0 + i), vry1, _CMP_LE_OQ),
+                          _mm256_cmp_ps(_mm256_loadu_ps(oy1 + i), vry0, _CMP_GE_OQ)));
+        int bits = _mm256_movemask_ps(m);
+        for (int j = 0; bits != 0; j++, bits >>= 1) {
+            if (bits & 1) addPair(r, items[i + j]);
         }
-        subdivide();
     }
+#elif defined(QUADTREE_SSE2)
+    __m128 vrx0 = _mm_set1_ps(rx0), vry0 = _mm_set1_ps(ry0);
+    __m128 vrx1 = _mm_set1_ps(rx1), vry1 = _mm_set1_ps(ry1);
+    for (; i + 4 <= used; i += 4) {
+        __m128 m = _mm_and_ps(
+            _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(ox0 + i), vrx1), _mm_cmpge_ps(_mm_loadu_ps(ox1 + i), vrx0)),
+            _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(oy0 + i), vry1), _mm_cmpge_ps(_mm_loadu_ps(oy1 + i), vry0)));
+        int bits = _mm_movemask_ps(m);
+        for (int j = 0; bits != 0; j++, bits >>= 1) {
+            if (bits & 1) addPair(r, items[i + j]);
+        }
+    }
+#endif
+    // Resto del bloque (o todo, sin SIMD): misma prueba que CustomRectangle::intersects
+    for (; i < used; i++) {
+        if (ox0[i] <= rx1 && ox1[i] >= rx0 && oy0[i] <= ry1 && oy1[i] >= ry0) addPair(r, items[i]);
+    }
+}
 
-    // IMPORTANTE: Se intenta insertar en TODOS los hijos.
-    // Un objeto puede vivir en varios cuadrantes si está en la frontera.
-    bool i1 = nw->insert(object);
-    bool i2 = ne->insert(object);
-    bool i3 = sw->insert(object);
-    bool i4 = se->insert(object);
+NearestQueue::NearestQueue() : keys(nullptr), items(nullptr), ties(nullptr), count(0), capacity(0) {}
 
-    return (i1 || i2 || i3 || i4);
+NearestQueue::~NearestQueue() {
+    delete[] keys;
+    delete[] items;
+    delete[] ties;
 }
 
-void QuadTree::query(const CustomRectangle& range, GameObjectList& foundList) const {
-    if (!boundary.intersects(range)) return;
+void NearestQueue::grow() {
+    int newCap = capacity > 0 ? capacity * 2 : 64;
+    float* newKeys = new float[newCap];
+    int* newItems = new int[newCap];
+    int* newTies = new int[newCap];
+    for (int i = 0; i < count; i++) {
+        newKeys[i] = keys[i];
+        newItems[i] = items[i];
+        newTies[i] = ties[i];
+    }
+    delete[] keys;
+    delete[] items;
+    delete[] ties;
+    keys = newKeys;
+    items = newItems;
+    ties = newTies;
+    capacity = newCap;
+}
 
-    if (!divided) {
-        for (int i = 0; i < objects.size(); i++) {
-            if (range.intersects(objects.get(i).getBounds())) {
-                foundList.add(objects.get(i));
-            }
-        }
-    } else {
-        nw->query(range, foundList);
-        ne->query(range, foundList);
-        sw->query(range, foundList);
-        se->query(range, foundList);
+void NearestQueue::push(float key, int item, int tie) {
+    if (count == capacity) grow();
+    // Subir el hueco hasta que el padre no vaya detrás
+    int i = count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!before(key, tie, keys[parent], ties[parent])) break;
+        keys[i] = keys[parent];
+        items[i] = items[parent];
+        ties[i] = ties[parent];
+        i = parent;
     }
+    keys[i] = key;
+    items[i] = item;
+    ties[i] = tie;
 }
 
-void QuadTree::clear() {
-    objects.clear();
-    if (divided) {
-        delete nw; delete ne; delete sw; delete se;
-        nw = ne = sw = se = nullptr;
-        divided = false;
+bool NearestQueue::pop(float& key, int& item) {
+    if (count == 0) return false;
+    key = keys[0];
+    item = items[0];
+    float lastKey = keys[--count];
+    int lastItem = items[count];
+    int lastTie = ties[count];
+    // Bajar el último elemento desde la raíz por el hijo menor
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= count) break;
+        if (child + 1 < count && before(keys[child + 1], ties[child + 1], keys[child], ties[child])) child++;
+        if (!before(keys[child], ties[child], lastKey, lastTie)) break;
+        keys[i] = keys[child];
+        items[i] = items[child];
+        ties[i] = ties[child];
+        i = child;
     }
-}
\ No newline at end of file
+    keys[i] = lastKey;
+    items[i] = lastItem;
+    ties[i] = lastTie;
+    return true;
+}
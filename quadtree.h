@@ -1,6 +1,8 @@
 #ifndef QUADTREE_H
 #define QUADTREE_H
 
+#include "jobs.h"
+
 struct Point {
     float x, y;
     Point(float _x = 0, float _y = 0) : x(_x), y(_y) {}
@@ -60,22 +62,848 @@ public:
     void clear() { currentSize = 0; }
 };
 
-class QuadTree {
+// Vista sobre el buffer reutilizable de QuadTree::queryHandles (válida hasta la siguiente consulta)
+struct HandleSpan {
+    const int* data;
+    int count;
+    int size() const { return count; }
+    int operator[](int i) const { return data[i]; }
+    const int* begin() const { return data; }
+    const int* end() const { return data + count; }
+};
+
+// Resultados de una consulta por lotes: una vista de handles únicos por rango, en el mismo
+// orden en que los devolvería queryHandles. Se reutiliza entre frames sin volver a reservar.
+class QueryBatch {
 private:
-    CustomRectangle boundary;
-    int capacity;
-    int maxDepth;
-    int currentDepth;
-    GameObjectList objects;
-    bool divided;
-    QuadTree *nw, *ne, *sw, *se;
-    void subdivide();
+    int* handles;
+    int handleCount, handleCapacity;
+    int* rangeStart;
+    int* rangeEnd;
+    int rangeCount, rangeCapacity;
+    // Espacio de trabajo del recorrido: pares (rango, objeto), listas de rangos activos y AABB de los rangos
+    int* pairRange;
+    int* pairObject;
+    int pairCount, pairCapacity;
+    int* active;
+    int activeCapacity;
+    float* minX;
+    float* minY;
+    float* maxX;
+    float* maxY;
+
+    template <typename T> static void resizeArray(T*& data, int used, int newCap);
+    void reserveRanges(int need);
+    void reserveHandles(int need);
+    void prepare(int ranges, int activeNeed);
+    // Prueba los rangos contra las 'used' cajas de un bloque de hoja (SIMD si hay) y añade los pares
+    void collectBlock(int range, const int* items, const float* ox0, const float* oy0,
+                      const float* ox1, const float* oy1, int used);
+    void addPair(int range, int object) {
+        if (pairCount == pairCapacity) {
+            int newCap = pairCapacity > 0 ? pairCapacity * 2 : 256;
+            resizeArray(pairRange, pairCount, newCap);
+            resizeArray(pairObject, pairCount, newCap);
+            pairCapacity = newCap;
+        }
+        pairRange[pairCount] = range;
+        pairObject[pairCount] = object;
+        pairCount++;
+    }
+
+    QueryBatch(const QueryBatch&) = delete;
+    QueryBatch& operator=(const QueryBatch&) = delete;
+    template <typename, int, int, typename> friend class BasicQuadTree;
+public:
+    QueryBatch();
+    ~QueryBatch();
+    // Llenado secuencial (rango a rango) para broadphases sin recorrido por lotes
+    void clear() { handleCount = 0; rangeCount = 0; }
+    void beginRange();
+    void add(int handle);
+    int size() const { return rangeCount; }
+    HandleSpan get(int range) const {
+        HandleSpan span = { handles + rangeStart[range], rangeEnd[range] - rangeStart[range] };
+        return span;
+    }
+};
+
+// Distancia al cuadrado de 'p' al rectángulo (0 si está dentro): cota inferior para podar nodos
+inline float PointRectDistance2(const Point& p, const CustomRectangle& r) {
+    float dx = p.x < r.x - r.width/2 ? (r.x - r.width/2) - p.x : (p.x > r.x + r.width/2 ? p.x - (r.x + r.width/2) : 0.0f);
+    float dy = p.y < r.y - r.height/2 ? (r.y - r.height/2) - p.y : (p.y > r.y + r.height/2 ? p.y - (r.y + r.height/2) : 0.0f);
+    return dx*dx + dy*dy;
+}
+
+// Tiempo de impacto de una caja de semiextensión (hx, hy) que se mueve de 'from' a 'from + delta'
+// contra 'box' (método de las losas sobre 'box' ampliada por la semiextensión; con hx = hy = 0 es
+// un segmento). true si se tocan en algún t de [0, 1]; 'toi' recibe el primero (0 si ya se tocaban).
+inline bool SweptBoxToi(const Point& from, const Point& delta, float hx, float hy, const CustomRectangle& box, float& toi) {
+    float tEnter = 0.0f, tExit = 1.0f;
+    const float start[2] = { from.x, from.y };
+    const float move[2] = { delta.x, delta.y };
+    const float lo[2] = { box.x - box.width/2 - hx, box.y - box.height/2 - hy };
+    const float hi[2] = { box.x + box.width/2 + hx, box.y + box.height/2 + hy };
+    for (int axis = 0; axis < 2; axis++) {
+        if (move[axis] == 0.0f) {
+            if (start[axis] < lo[axis] || start[axis] > hi[axis]) return false;
+            continue;
+        }
+        float inv = 1.0f / move[axis];
+        float t1 = (lo[axis] - start[axis]) * inv;
+        float t2 = (hi[axis] - start[axis]) * inv;
+        if (t1 > t2) { float t = t1; t1 = t2; t2 = t; }
+        if (t1 > tEnter) tEnter = t1;
+        if (t2 < tExit) tExit = t2;
+        if (tEnter > tExit) return false;
+    }
+    toi = tEnter;
+    return true;
+}
+
+// Montículo mínimo de pares (distancia al cuadrado, elemento) para las búsquedas best-first.
+// A igual distancia sale antes el desempate menor: los nodos (negativos) antes que los objetos y,
+// entre objetos, el handle menor. Así el resultado no depende de la forma del árbol.
+// Conserva su memoria entre búsquedas.
+class NearestQueue {
+private:
+    float* keys;
+    int* items;
+    int* ties;
+    int count, capacity;
+
+    void grow();
+    static bool before(float k1, int t1, float k2, int t2) { return k1 < k2 || (k1 == k2 && t1 < t2); }
+
+    NearestQueue(const NearestQueue&) = delete;
+    NearestQueue& operator=(const NearestQueue&) = delete;
+public:
+    NearestQueue();
+    ~NearestQueue();
+    void clear() { count = 0; }
+    bool empty() const { return count == 0; }
+    // Clave mínima sin sacarla (la cola no puede estar vacía)
+    float minKey() const { return keys[0]; }
+    // 'tie' desempata a igual clave; sin él desempata el propio elemento
+    void push(float key, int item, int tie);
+    void push(float key, int item) { push(key, item, item); }
+    // Saca el par de menor clave; false si la cola está vacía
+    bool pop(float& key, int& item);
+};
+
+// Caja de la carga al insertarla. El árbol guarda su propia copia: las consultas no vuelven a la carga.
+struct GameObjectBounds {
+    static CustomRectangle bounds(const GameObject& obj) { return obj.getBounds(); }
+};
+// Cargas sin caja propia: se pasa en insert(payload, bounds, handle)
+struct ExplicitBounds {};
+
+// Carga compacta: el tipo en un byte; el índice ya es el handle del árbol
+struct TypeTag {
+    unsigned char type;
+    TypeTag(int t = 0) : type((unsigned char)t) {}
+};
+// Para árboles en los que la carga no aporta nada (TypedQuadTree: el tipo lo da el árbol)
+struct NoPayload {};
+
+inline int PayloadType(const GameObject& obj) { return obj.type; }
+inline int PayloadType(const TypeTag& tag) { return tag.type; }
+
+// Filtro por tipo fijado al compilar, para nearest() y sweep()
+template <int Type>
+struct OfType {
+    template <typename Payload>
+    bool operator()(const Payload& p, int) const { return PayloadType(p) == Type; }
+};
+
+// QuadTree genérico. De cada objeto guarda su carga (Payload), su caja y su handle; los visitantes
+// reciben (const Payload&, int handle). BoundsPolicy::bounds(payload) da la caja en insert(payload, handle)
+// y en build(). Capacity y MaxDepth son constantes: cada bloque de hoja tiene sitio fijo para Capacity
+// entradas y el límite de profundidad se compara con una constante. El árbol del juego es la
+// instancia QuadTree de más abajo.
+template <typename Payload, int Capacity, int MaxDepth, typename BoundsPolicy = ExplicitBounds>
+class BasicQuadTree {
+    static_assert(Capacity >= 1, "una hoja necesita sitio para al menos un objeto");
+    static_assert(MaxDepth >= 0, "profundidad máxima negativa");
+private:
+    // Nodo del arena: los hijos se reservan contiguos (nw, ne, sw, se) a partir de firstChild
+    struct Node {
+        CustomRectangle boundary;
+        int depth;
+        int firstChild;  // -1 si es hoja
+        int firstBlock;  // cadena de bloques con los índices de objetos de la hoja
+        int count;
+    };
+    // Entradas de una hoja: índices a 'objects' y sus AABB precalculados en SoA para las pruebas SIMD
+    struct Block {
+        int items[Capacity];
+        float minX[Capacity];
+        float minY[Capacity];
+        float maxX[Capacity];
+        float maxY[Capacity];
+        int used;
+        int next;
+    };
+
+    CustomRectangle rootBoundary;
+    int rootDepth;            // 1 en los subárboles de build(): comparten el límite MaxDepth
+
+    // Arena persistente: clear() solo reinicia contadores y conserva la memoria
+    Node* nodes;
+    int nodeCount, nodeCapacity;
+    Payload* objects;         // cada objeto se guarda una sola vez
+    CustomRectangle* objectBounds;
+    int* objectHandles;       // índice original del objeto en el arreglo del llamador
+    unsigned* objectStamps;   // marca de la última consulta que lo devolvió
+    int objectCount, objectCapacity;
+    unsigned queryStamp;
+    int* scratch;             // resultados de queryHandles
+    int scratchCount, scratchCapacity;
+    Block* blocks;
+    int blockCount, blockCapacity;
+    int freeBlock;
+    BasicQuadTree* quadrants[4]; // árboles auxiliares de build() en paralelo, uno por cuadrante de la raíz
+    int entryCount;           // referencias en hojas: los objetos de frontera cuentan varias veces
+    long long allocations;
+
+    template <typename T>
+    void reserveArray(T*& data, int used, int newCap) {
+        T* newData = new T[newCap];
+        for (int i = 0; i < used; i++) newData[i] = data[i];
+        delete[] data;
+        data = newData;
+        allocations++;
+    }
+
+    void reserveBlocks(int need) {
+        if (need <= blockCapacity) return;
+        int newCap = blockCapacity > 0 ? blockCapacity * 2 : 64;
+        while (newCap < need) newCap *= 2;
+        reserveArray(blocks, blockCount, newCap);
+        blockCapacity = newCap;
+    }
+
+    int reserveObject() {
+        if (objectCount == objectCapacity) {
+            int newCap = objectCapacity > 0 ? objectCapacity * 2 : 64;
+            reserveArray(objects, objectCount, newCap);
+            reserveArray(objectBounds, objectCount, newCap);
+            reserveArray(objectHandles, objectCount, newCap);
+            reserveArray(objectStamps, objectCount, newCap);
+            objectCapacity = newCap;
+        }
+        return objectCount++;
+    }
+
+    int allocNodes(int n) {
+        if (nodeCount + n > nodeCapacity) {
+            int newCap = nodeCapacity > 0 ? nodeCapacity * 2 : 64;
+            while (newCap < nodeCount + n) newCap *= 2;
+            reserveArray(nodes, nodeCount, newCap);
+            nodeCapacity = newCap;
+        }
+        int first = nodeCount;
+        nodeCount += n;
+        return first;
+    }
+
+    int allocBlock() {
+        int b;
+        if (freeBlock != -1) {
+            b = freeBlock;
+            freeBlock = blocks[b].next;
+        } else {
+            reserveBlocks(blockCount + 1);
+            b = blockCount++;
+        }
+        blocks[b].used = 0;
+        blocks[b].next = -1;
+        return b;
+    }
+
+    void addToLeaf(int node, int objIndex) {
+        int b = nodes[node].firstBlock;
+        if (b == -1 || blocks[b].used == Capacity) {
+            // Solo las hojas en profundidad máxima encadenan más de un bloque
+            int nb = allocBlock();
+            blocks[nb].next = b;
+            nodes[node].firstBlock = nb;
+            b = nb;
+        }
+        Block& blk = blocks[b];
+        int slot = blk.used++;
+        const CustomRectangle& box = objectBounds[objIndex];
+        blk.items[slot] = objIndex;
+        blk.minX[slot] = box.x - box.width/2;
+        blk.minY[slot] = box.y - box.height/2;
+        blk.maxX[slot] = box.x + box.width/2;
+        blk.maxY[slot] = box.y + box.height/2;
+        nodes[node].count++;
+        entryCount++;
+    }
+
+    void subdivide(int node) {
+        CustomRectangle bnd = nodes[node].boundary;
+        int depth = nodes[node].depth + 1;
+        float x = bnd.x;
+        float y = bnd.y;
+        float w = bnd.width / 2.0f;
+        float h = bnd.height / 2.0f;
+
+        // Los centros de los nuevos cuadrantes se calculan desplazando w/4 desde el centro original
+        int first = allocNodes(4);
+        CustomRectangle quads[4] = {
+            CustomRectangle(x - w/2, y - h/2, w, h),
+            CustomRectangle(x + w/2, y - h/2, w, h),
+            CustomRectangle(x - w/2, y + h/2, w, h),
+            CustomRectangle(x + w/2, y + h/2, w, h)
+        };
+        for (int q = 0; q < 4; q++) {
+            Node& child = nodes[first + q];
+            child.boundary = quads[q];
+            child.depth = depth;
+            child.firstChild = -1;
+            child.firstBlock = -1;
+            child.count = 0;
+        }
+
+        // RE-INSERTAR objetos del nodo actual en los hijos y devolver sus bloques a la lista libre
+        int b = nodes[node].firstBlock;
+        entryCount -= nodes[node].count;
+        nodes[node].firstChild = first;
+        nodes[node].firstBlock = -1;
+        nodes[node].count = 0;
+        while (b != -1) {
+            for (int i = 0; i < blocks[b].used; i++) {
+                int objIndex = blocks[b].items[i];
+                for (int q = 0; q < 4; q++) insertAt(first + q, objIndex);
+            }
+            int next = blocks[b].next;
+            blocks[b].next = freeBlock;
+            freeBlock = b;
+            b = next;
+        }
+    }
+
+    void insertAt(int node, int objIndex) {
+        // Si el objeto no está ni siquiera cerca de este cuadrante, salir
+        if (!nodes[node].boundary.intersects(objectBounds[objIndex])) return;
+
+        if (nodes[node].firstChild == -1) {
+            // Si hay espacio o llegamos al límite de profundidad, guardar aquí
+            if (nodes[node].count < Capacity || nodes[node].depth >= MaxDepth) {
+                addToLeaf(node, objIndex);
+                return;
+            }
+            subdivide(node);
+        }
+
+        // IMPORTANTE: Se intenta insertar en TODOS los hijos.
+        // Un objeto puede vivir en varios cuadrantes si está en la frontera.
+        int first = nodes[node].firstChild;
+        for (int q = 0; q < 4; q++) insertAt(first + q, objIndex);
+    }
+
+    void queryAt(int node, const CustomRectangle& range, GameObjectList& foundList) const {
+        const Node& n = nodes[node];
+        if (!n.boundary.intersects(range)) return;
+
+        if (n.firstChild == -1) {
+            for (int b = n.firstBlock; b != -1; b = blocks[b].next) {
+                for (int i = 0; i < blocks[b].used; i++) {
+                    int objIndex = blocks[b].items[i];
+                    if (range.intersects(objectBounds[objIndex])) foundList.add(objects[objIndex]);
+                }
+            }
+        } else {
+            for (int q = 0; q < 4; q++) queryAt(n.firstChild + q, range, foundList);
+        }
+    }
+
+    unsigned nextStamp() {
+        if (++queryStamp == 0) {
+            // Desbordamiento del contador: se reinician las marcas para no confundir consultas viejas
+            for (int i = 0; i < objectCount; i++) objectStamps[i] = 0;
+            queryStamp = 1;
+        }
+        return queryStamp;
+    }
+
+    void batchAt(int node, int* act, int actCount, QueryBatch& batch) const {
+        const Node& n = nodes[node];
+        float nx0 = n.boundary.x - n.boundary.width/2;
+        float nx1 = n.boundary.x + n.boundary.width/2;
+        float ny0 = n.boundary.y - n.boundary.height/2;
+        float ny1 = n.boundary.y + n.boundary.height/2;
+
+        // Rangos del lote que tocan este nodo; la lista del hijo se apila justo detrás de la del padre
+        int* next = act + actCount;
+        int nextCount = 0;
+        for (int k = 0; k < actCount; k++) {
+            int r = act[k];
+            if (!(batch.minX[r] > nx1 || batch.maxX[r] < nx0 || batch.minY[r] > ny1 || batch.maxY[r] < ny0)) next[nextCount++] = r;
+        }
+        if (nextCount == 0) return;
+
+        if (n.firstChild != -1) {
+            for (int q = 0; q < 4; q++) batchAt(n.firstChild + q, next, nextCount, batch);
+            return;
+        }
+        for (int b = n.firstBlock; b != -1; b = blocks[b].next) {
+            const Block& blk = blocks[b];
+            for (int k = 0; k < nextCount; k++) {
+                batch.collectBlock(next[k], blk.items, blk.minX, blk.minY, blk.maxX, blk.maxY, blk.used);
+            }
+        }
+    }
+
+    void graft(int node, const BasicQuadTree& sub) {
+        // La raíz del subárbol ocupa 'node'; el resto de sus nodos y bloques se copian al final
+        // del arena desplazando los índices. Sus objetos ya están aquí: el handle de cada uno es
+        // su índice en 'objects'. El subárbol empieza en profundidad 1, así que las profundidades valen tal cual.
+        int nodeBase = sub.nodeCount > 1 ? allocNodes(sub.nodeCount - 1) - 1 : 0;
+        reserveBlocks(blockCount + sub.blockCount);
+        int blockBase = blockCount;
+        blockCount += sub.blockCount;
+
+        for (int i = 0; i < sub.nodeCount; i++) {
+            const Node& src = sub.nodes[i];
+            Node& dst = nodes[i == 0 ? node : nodeBase + i];
+            dst.boundary = src.boundary;
+            dst.depth = src.depth;
+            dst.firstChild = src.firstChild == -1 ? -1 : nodeBase + src.firstChild;
+            dst.firstBlock = src.firstBlock == -1 ? -1 : blockBase + src.firstBlock;
+            dst.count = src.count;
+        }
+        for (int b = 0; b < sub.blockCount; b++) {
+            const Block& src = sub.blocks[b];
+            Block& dst = blocks[blockBase + b];
+            dst.used = src.used;
+            dst.next = src.next == -1 ? -1 : blockBase + src.next;
+            for (int i = 0; i < src.used; i++) {
+                dst.items[i] = sub.objectHandles[src.items[i]];
+                dst.minX[i] = src.minX[i];
+                dst.minY[i] = src.minY[i];
+                dst.maxX[i] = src.maxX[i];
+                dst.maxY[i] = src.maxY[i];
+            }
+        }
+        // Los bloques que el subárbol liberó al subdividir pasan a la lista libre de este árbol
+        for (int b = sub.freeBlock; b != -1; ) {
+            int next = sub.blocks[b].next;
+            blocks[blockBase + b].next = freeBlock;
+            freeBlock = blockBase + b;
+            b = next;
+        }
+        entryCount += sub.entryCount;
+    }
+
+    template <typename Visitor>
+    bool scanAt(int node, const CustomRectangle& range, Visitor& fn) const {
+        const Node& n = nodes[node];
+        if (!n.boundary.intersects(range)) return true;
+
+        if (n.firstChild == -1) {
+            for (int b = n.firstBlock; b != -1; b = blocks[b].next) {
+                for (int i = 0; i < blocks[b].used; i++) {
+                    int objIndex = blocks[b].items[i];
+                    if (range.intersects(objectBounds[objIndex]) &&
+                        !fn(objects[objIndex], objectHandles[objIndex])) return false;
+                }
+            }
+            return true;
+        }
+        for (int q = 0; q < 4; q++) {
+            if (!scanAt(n.firstChild + q, range, fn)) return false;
+        }
+        return true;
+    }
+
+    template <typename Visitor>
+    bool visitAt(int node, const CustomRectangle& range, unsigned stamp, Visitor& fn) {
+        const Node& n = nodes[node];
+        if (!n.boundary.intersects(range)) return true;
+
+        if (n.firstChild == -1) {
+            for (int b = n.firstBlock; b != -1; b = blocks[b].next) {
+                for (int i = 0; i < blocks[b].used; i++) {
+                    int objIndex = blocks[b].items[i];
+                    // Un objeto en la frontera vive en varias hojas: solo se visita la primera vez
+                    if (objectStamps[objIndex] == stamp) continue;
+                    objectStamps[objIndex] = stamp;
+                    if (range.intersects(objectBounds[objIndex]) &&
+                        !fn(objects[objIndex], objectHandles[objIndex])) return false;
+                }
+            }
+            return true;
+        }
+        for (int q = 0; q < 4; q++) {
+            if (!visitAt(n.firstChild + q, range, stamp, fn)) return false;
+        }
+        return true;
+    }
+
+    // Hijos en el orden en que los cruza el trayecto; se deja de bajar en cuanto el siguiente
+    // empieza después del mejor impacto encontrado
+    template <typename Filter>
+    void sweepAt(int node, const Point& from, const Point& delta, float hx, float hy, Filter& accept,
+                 int& best, float& bestToi, int& tested) const {
+        const Node& n = nodes[node];
+        float t;
+        if (n.firstChild == -1) {
+            for (int b = n.firstBlock; b != -1; b = blocks[b].next) {
+                for (int i = 0; i < blocks[b].used; i++) {
+                    int objIndex = blocks[b].items[i];
+                    tested++;
+                    // A igual tiempo, el handle menor: no depende del orden del recorrido
+                    if (!SweptBoxToi(from, delta, hx, hy, objectBounds[objIndex], t) || t > bestToi) continue;
+                    if (t == bestToi && objectHandles[objIndex] >= best) continue;
+                    if (!accept(objects[objIndex], objectHandles[objIndex])) continue;
+                    best = objectHandles[objIndex];
+                    bestToi = t;
+                }
+            }
+            return;
+        }
+        int order[4];
+        float enter[4];
+        int crossed = 0;
+        for (int q = 0; q < 4; q++) {
+            // Un hijo que empieza justo en bestToi puede tener un empate con handle menor
+            if (!SweptBoxToi(from, delta, hx, hy, nodes[n.firstChild + q].boundary, t) || t > bestToi) continue;
+            int k = crossed++;
+            while (k > 0 && enter[k - 1] > t) { enter[k] = enter[k - 1]; order[k] = order[k - 1]; k--; }
+            enter[k] = t;
+            order[k] = n.firstChild + q;
+        }
+        for (int k = 0; k < crossed && enter[k] <= bestToi; k++) {
+            sweepAt(order[k], from, delta, hx, hy, accept, best, bestToi, tested);
+        }
+    }
+
+    BasicQuadTree(const BasicQuadTree&) = delete;
+    BasicQuadTree& operator=(const BasicQuadTree&) = delete;
 public:
-    QuadTree(const CustomRectangle& b, int cap = 50, int mD = 8, int d = 0);
-    ~QuadTree();
-    bool insert(const GameObject& object);
-    void query(const CustomRectangle& range, GameObjectList& foundList) const;
-    void clear();
+    explicit BasicQuadTree(const CustomRectangle& b)
+        : rootBoundary(b), rootDepth(0),
+          nodes(nullptr), nodeCount(0), nodeCapacity(0),
+          objects(nullptr), objectBounds(nullptr), objectHandles(nullptr), objectStamps(nullptr),
+          objectCount(0), objectCapacity(0), queryStamp(0),
+          scratch(nullptr), scratchCount(0), scratchCapacity(0),
+          blocks(nullptr), blockCount(0), blockCapacity(0), freeBlock(-1), entryCount(0), allocations(0) {
+        for (int q = 0; q < 4; q++) quadrants[q] = nullptr;
+        clear();
+    }
+
+    ~BasicQuadTree() {
+        delete[] nodes;
+        delete[] objects;
+        delete[] objectBounds;
+        delete[] objectHandles;
+        delete[] objectStamps;
+        delete[] scratch;
+        delete[] blocks;
+        for (int q = 0; q < 4; q++) delete quadrants[q];
+    }
+
+    // 'handle' es el índice del objeto en el arreglo del llamador (p. ej. el slot del asteroide)
+    bool insert(const Payload& payload, const CustomRectangle& bounds, int handle = -1) {
+        if (!rootBoundary.intersects(bounds)) return false;
+        int objIndex = reserveObject();
+        objects[objIndex] = payload;
+        objectBounds[objIndex] = bounds;
+        objectHandles[objIndex] = handle;
+        objectStamps[objIndex] = 0;
+        insertAt(0, objIndex);
+        return true;
+    }
+    // La caja sale de BoundsPolicy
+    bool insert(const Payload& payload, int handle = -1) {
+        return insert(payload, BoundsPolicy::bounds(payload), handle);
+    }
+    // Copia cada coincidencia; los objetos de frontera aparecen una vez por hoja
+    void query(const CustomRectangle& range, GameObjectList& foundList) const {
+        queryAt(0, range, foundList);
+    }
+
+    // Sin copias ni duplicados: llama fn(const Payload&, int handle) una vez por objeto.
+    // El visitante devuelve false para detener la búsqueda.
+    template <typename Visitor>
+    void visit(const CustomRectangle& range, Visitor fn) {
+        visitAt(0, range, nextStamp(), fn);
+    }
+    // Como visit pero sin marcas: no modifica nada y admite varios hilos a la vez.
+    // Los objetos de frontera pueden aparecer una vez por hoja.
+    template <typename Visitor>
+    void scan(const CustomRectangle& range, Visitor fn) const {
+        scanAt(0, range, fn);
+    }
+    // Handles únicos de los objetos que intersectan 'range'
+    HandleSpan queryHandles(const CustomRectangle& range) {
+        scratchCount = 0;
+        visit(range, [this](const Payload&, int handle) {
+            if (scratchCount == scratchCapacity) {
+                int newCap = scratchCapacity > 0 ? scratchCapacity * 2 : 64;
+                reserveArray(scratch, scratchCount, newCap);
+                scratchCapacity = newCap;
+            }
+            scratch[scratchCount++] = handle;
+            return true;
+        });
+        HandleSpan span = { scratch, scratchCount };
+        return span;
+    }
+
+    // Los k objetos cuyo centro está más cerca de 'p' (como mucho a maxRadius), del más cercano
+    // al más lejano. Recorre los nodos por distancia mínima y se detiene al tener k resultados.
+    // accept(const Payload&, int handle) descarta candidatos (p. ej. OfType<2>()).
+    // La poda supone que los centros están dentro de la raíz, como en el juego (el mundo se envuelve).
+    // 'queue' es memoria de trabajo del llamador: no se toca el árbol, así que con una cola
+    // por hilo se puede buscar desde varios hilos a la vez.
+    // Devuelve cuántos handles (únicos) escribió en outHandles; outDist2 (opcional) recibe sus distancias al cuadrado.
+    template <typename Filter>
+    int nearest(const Point& p, int k, float maxRadius, Filter accept, NearestQueue& queue,
+                int* outHandles, float* outDist2 = nullptr) const {
+        if (k <= 0) return 0;
+        float maxD2 = maxRadius * maxRadius;
+        queue.clear();
+        queue.push(PointRectDistance2(p, nodes[0].boundary), -1);
+
+        // Durante la búsqueda outHandles guarda índices de objeto; al final se traducen a handles
+        int found = 0;
+        float key;
+        int item;
+        while (found < k && queue.pop(key, item)) {
+            // Todo lo que queda en la cola está al menos a 'key': nada más puede entrar
+            if (key > maxD2) break;
+            if (item >= 0) {
+                // Un objeto de frontera llega una vez por hoja; una copia del mismo handle, también
+                bool repeated = false;
+                for (int j = 0; j < found && !repeated; j++) {
+                    int other = outHandles[j];
+                    repeated = other == item || (objectHandles[item] != -1 && objectHandles[other] == objectHandles[item]);
+                }
+                if (repeated) continue;
+                outHandles[found] = item;
+                if (outDist2) outDist2[found] = key;
+                found++;
+                continue;
+            }
+            const Node& n = nodes[-item - 1];
+            if (n.firstChild == -1) {
+                for (int b = n.firstBlock; b != -1; b = blocks[b].next) {
+                    for (int i = 0; i < blocks[b].used; i++) {
+                        int objIndex = blocks[b].items[i];
+                        if (!accept(objects[objIndex], objectHandles[objIndex])) continue;
+                        float dx = objectBounds[objIndex].x - p.x, dy = objectBounds[objIndex].y - p.y;
+                        float d2 = dx*dx + dy*dy;
+                        if (d2 <= maxD2) queue.push(d2, objIndex, objectHandles[objIndex]);
+                    }
+                }
+            } else {
+                // La hoja que contiene el centro de un objeto está a menos distancia que el propio centro
+                for (int q = 0; q < 4; q++) {
+                    float d2 = PointRectDistance2(p, nodes[n.firstChild + q].boundary);
+                    if (d2 <= maxD2) queue.push(d2, -(n.firstChild + q) - 1);
+                }
+            }
+        }
+        for (int j = 0; j < found; j++) outHandles[j] = objectHandles[outHandles[j]];
+        return found;
+    }
+    // Primer objeto que toca una caja de semiextensión (hx, hy) al moverse de 'from' a 'to'
+    // (hx = hy = 0: un segmento). Solo visita los nodos que cruza el trayecto, de delante atrás,
+    // así que una bala no atraviesa asteroides pequeños aunque avance más que su tamaño en un tick.
+    // accept(const Payload&, int handle) descarta candidatos. Devuelve el handle o -1; 'toi'
+    // recibe la fracción del trayecto en [0, 1] del contacto. No modifica el árbol (varios hilos).
+    template <typename Filter>
+    int sweep(const Point& from, const Point& to, float hx, float hy, Filter accept, float& toi, int* testedOut = nullptr) const {
+        Point delta(to.x - from.x, to.y - from.y);
+        int best = -1;
+        float bestToi = 2.0f; // cualquier impacto real está en [0, 1]
+        int tested = 0;
+        float t;
+        if (SweptBoxToi(from, delta, hx, hy, nodes[0].boundary, t)) {
+            sweepAt(0, from, delta, hx, hy, accept, best, bestToi, tested);
+        }
+        if (testedOut) *testedOut = tested;
+        if (best != -1) toi = bestToi;
+        return best;
+    }
+    // Recorre el árbol una sola vez para todos los rangos; out.get(r) equivale a queryHandles(ranges[r])
+    void queryBatch(const CustomRectangle* ranges, int rangeCount, QueryBatch& out) {
+        out.prepare(rangeCount, rangeCount * (MaxDepth + 2));
+        for (int r = 0; r < rangeCount; r++) {
+            out.minX[r] = ranges[r].x - ranges[r].width/2;
+            out.minY[r] = ranges[r].y - ranges[r].height/2;
+            out.maxX[r] = ranges[r].x + ranges[r].width/2;
+            out.maxY[r] = ranges[r].y + ranges[r].height/2;
+            out.active[r] = r;
+        }
+        if (rangeCount == 0) return;
+        batchAt(0, out.active, rangeCount, out);
+
+        // Counting sort estable de los pares por rango (rangeEnd hace de contador y luego de cursor)
+        for (int r = 0; r < rangeCount; r++) out.rangeEnd[r] = 0;
+        for (int p = 0; p < out.pairCount; p++) out.rangeEnd[out.pairRange[p]]++;
+        int sum = 0;
+        for (int r = 0; r < rangeCount; r++) {
+            out.rangeStart[r] = sum;
+            sum += out.rangeEnd[r];
+            out.rangeEnd[r] = out.rangeStart[r];
+        }
+        out.reserveHandles(out.pairCount);
+        for (int p = 0; p < out.pairCount; p++) out.handles[out.rangeEnd[out.pairRange[p]]++] = out.pairObject[p];
+
+        // Quitar los duplicados de frontera de cada rango y traducir a handles, compactando en sitio
+        int w = 0;
+        for (int r = 0; r < rangeCount; r++) {
+            unsigned stamp = nextStamp();
+            int s0 = out.rangeStart[r];
+            int e0 = out.rangeEnd[r];
+            out.rangeStart[r] = w;
+            for (int k = s0; k < e0; k++) {
+                int objIndex = out.handles[k];
+                if (objectStamps[objIndex] == stamp) continue;
+                objectStamps[objIndex] = stamp;
+                out.handles[w++] = objectHandles[objIndex];
+            }
+            out.rangeEnd[r] = w;
+        }
+        out.handleCount = w;
+    }
+
+    void clear() {
+        // Reinicio O(1): la memoria del arena se conserva para el siguiente frame
+        nodeCount = 0;
+        objectCount = 0;
+        blockCount = 0;
+        freeBlock = -1;
+        entryCount = 0;
+        int root = allocNodes(1);
+        nodes[root].boundary = rootBoundary;
+        nodes[root].depth = rootDepth;
+        nodes[root].firstChild = -1;
+        nodes[root].firstBlock = -1;
+        nodes[root].count = 0;
+    }
+
+    // Vacía el árbol e inserta 'n' objetos (handles[i] es el handle de objs[i]). Con 'jobs' divide
+    // la raíz y construye los cuatro cuadrantes en paralelo; el árbol resultante responde igual
+    // que si se hubiera insertado uno a uno.
+    void build(const Payload* objs, const int* handles, int n, JobSystem* jobs = nullptr) {
+        clear();
+        if (!jobs || jobs->threadCount() == 1 || MaxDepth <= 0) {
+            for (int i = 0; i < n; i++) insert(objs[i], handles ? handles[i] : i);
+            return;
+        }
+
+        // Los objetos se guardan una sola vez aquí; los subárboles solo reparten sus índices
+        for (int i = 0; i < n; i++) {
+            CustomRectangle box = BoundsPolicy::bounds(objs[i]);
+            if (!rootBoundary.intersects(box)) continue;
+            int objIndex = reserveObject();
+            objects[objIndex] = objs[i];
+            objectBounds[objIndex] = box;
+            objectHandles[objIndex] = handles ? handles[i] : i;
+            objectStamps[objIndex] = 0;
+        }
+        // Si la raíz no llega a dividirse el árbol es una sola hoja
+        if (objectCount <= Capacity) {
+            for (int i = 0; i < objectCount; i++) addToLeaf(0, i);
+            return;
+        }
+
+        // Mismos cuadrantes que subdivide(); cada uno se construye como un árbol independiente
+        // cuya raíz está ya en profundidad 1, insertando los objetos en el mismo orden
+        subdivide(0);
+        int first = nodes[0].firstChild;
+        for (int q = 0; q < 4; q++) {
+            if (!quadrants[q]) {
+                quadrants[q] = new BasicQuadTree(nodes[first + q].boundary);
+                quadrants[q]->rootDepth = 1;
+            }
+        }
+        jobs->parallelFor(4, 1, [this](int begin, int end, int) {
+            for (int q = begin; q < end; q++) {
+                BasicQuadTree& sub = *quadrants[q];
+                sub.clear();
+                for (int i = 0; i < objectCount; i++) sub.insert(objects[i], objectBounds[i], i);
+            }
+        });
+        for (int q = 0; q < 4; q++) graft(first + q, *quadrants[q]);
+    }
+
+    int nodeTotal() const { return nodeCount; }
+    int objectTotal() const { return objectCount; }
+    // Referencias guardadas en hojas; entryTotal() - objectTotal() son las copias por frontera
+    int entryTotal() const { return entryCount; }
+    // Bytes reservados por el arena. Como nunca se libera hasta el destructor, es también el pico
+    long long memoryBytes() const {
+        long long bytes = (long long)nodeCapacity * sizeof(Node);
+        bytes += (long long)objectCapacity * (sizeof(Payload) + sizeof(CustomRectangle) + sizeof(int) + sizeof(unsigned));
+        bytes += (long long)scratchCapacity * sizeof(int);
+        bytes += (long long)blockCapacity * sizeof(Block);
+        for (int q = 0; q < 4; q++) {
+            if (quadrants[q]) bytes += quadrants[q]->memoryBytes();
+        }
+        return bytes;
+    }
+    // Número de reservas de memoria hechas por el arena desde su creación, con las de los
+    // subárboles de build() en paralelo (el propio subárbol cuenta como una)
+    long long allocationCount() const {
+        long long count = allocations;
+        for (int q = 0; q < 4; q++) {
+            if (quadrants[q]) count += 1 + quadrants[q]->allocationCount();
+        }
+        return count;
+    }
+};
+
+// El árbol clásico del juego: objetos completos, hojas de 50 y profundidad 8
+typedef BasicQuadTree<GameObject, 50, 8, GameObjectBounds> QuadTree;
+
+// Un árbol por tipo: una consulta de un solo tipo no recorre ni prueba los demás. El tipo es
+// un parámetro de plantilla, así que elegir el árbol no cuesta nada al consultar.
+template <int TypeCount, int Capacity, int MaxDepth>
+class TypedQuadTree {
+public:
+    typedef BasicQuadTree<NoPayload, Capacity, MaxDepth> Tree;
+private:
+    Tree* trees[TypeCount];
+
+    TypedQuadTree(const TypedQuadTree&) = delete;
+    TypedQuadTree& operator=(const TypedQuadTree&) = delete;
+public:
+    explicit TypedQuadTree(const CustomRectangle& b) {
+        for (int t = 0; t < TypeCount; t++) trees[t] = new Tree(b);
+    }
+    ~TypedQuadTree() {
+        for (int t = 0; t < TypeCount; t++) delete trees[t];
+    }
+    // false si el tipo no existe o el objeto cae fuera del mundo
+    bool insert(int type, const CustomRectangle& bounds, int handle) {
+        if (type < 0 || type >= TypeCount) return false;
+        return trees[type]->insert(NoPayload(), bounds, handle);
+    }
+    template <int Type>
+    Tree& of() {
+        static_assert(Type >= 0 && Type < TypeCount, "tipo fuera de rango");
+        return *trees[Type];
+    }
+    void clear() {
+        for (int t = 0; t < TypeCount; t++) trees[t]->clear();
+    }
+    int nodeTotal() const {
+        int total = 0;
+        for (int t = 0; t < TypeCount; t++) total += trees[t]->nodeTotal();
+        return total;
+    }
+    long long allocationCount() const {
+        long long total = 0;
+        for (int t = 0; t < TypeCount; t++) total += trees[t]->allocationCount();
+        return total;
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,341 @@
+// Benchmark de frames del broadphase sin ventana ni raylib.
+// Uso: quadtree_bench [asteroides] [frames]
+#include "quadtree.h"
+#include "loosequadtree.h"
+#include "spatialhash.h"
+#include "linearquadtree.h"
+#include "selfjoin.h"
+#include "jobs.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static const float WORLD_W = 1280.0f;
+static const float WORLD_H = 720.0f;
+static const int BULLETS = 60;
+
+// Generador fijo para que todas las variantes vean exactamente la misma partida
+struct BenchRng {
+    unsigned int state;
+    explicit BenchRng(unsigned int seed) : state(seed ? seed : 1u) {}
+    unsigned int next() {
+        state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+        return state;
+    }
+    float range(float lo, float hi) { return lo + (hi - lo) * (float)(next() & 0xFFFFFF) / 16777215.0f; }
+};
+
+struct Workload {
+    int count;
+    GameObject* objects;
+    float* vx;
+    float* vy;
+    GameObject bullets[BULLETS];
+    float bvx[BULLETS], bvy[BULLETS];
+
+    Workload(int n, unsigned int seed) : count(n) {
+        objects = new GameObject[n];
+        vx = new float[n];
+        vy = new float[n];
+        BenchRng rng(seed);
+        for (int i = 0; i < n; i++) {
+            int size = 1 + (int)(rng.next() % 3);
+            objects[i].position = Point(rng.range(0, WORLD_W), rng.range(0, WORLD_H));
+            objects[i].width = objects[i].height = size * 30.0f;
+            objects[i].type = 2;
+            objects[i].id = i;
+            vx[i] = rng.range(-2.5f, 2.5f);
+            vy[i] = rng.range(-2.5f, 2.5f);
+        }
+        for (int b = 0; b < BULLETS; b++) {
+            bullets[b].position = Point(rng.range(0, WORLD_W), rng.range(0, WORLD_H));
+            bullets[b].width = bullets[b].height = 10;
+            float a = rng.range(0, 6.2831853f);
+            bvx[b] = 12.0f * cosf(a);
+            bvy[b] = 12.0f * sinf(a);
+        }
+    }
+    ~Workload() { delete[] objects; delete[] vx; delete[] vy; }
+
+    // Integración idéntica a la del juego: mover y envolver en los bordes
+    void step() {
+        for (int i = 0; i < count; i++) {
+            Point& p = objects[i].position;
+            p.x += vx[i]; p.y += vy[i];
+            if (p.x > WORLD_W) p.x = 0; else if (p.x < 0) p.x = WORLD_W;
+            if (p.y > WORLD_H) p.y = 0; else if (p.y < 0) p.y = WORLD_H;
+        }
+        for (int b = 0; b < BULLETS; b++) {
+            Point& p = bullets[b].position;
+            p.x += bvx[b]; p.y += bvy[b];
+            if (p.x > WORLD_W) p.x = 0; else if (p.x < 0) p.x = WORLD_W;
+            if (p.y > WORLD_H) p.y = 0; else if (p.y < 0) p.y = WORLD_H;
+        }
+    }
+};
+
+template <typename Tree>
+static unsigned long long runQueries(Tree& tree, const Workload& w) {
+    unsigned long long checksum = 0;
+    for (int b = 0; b < BULLETS; b++) {
+        tree.visit(w.bullets[b].getBounds(), [&](const GameObject& obj, int handle) {
+            checksum += (unsigned long long)(handle + 1) * (unsigned long long)(b + 1) + (obj.type == 2);
+            return true;
+        });
+    }
+    return checksum;
+}
+
+static double nowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char* name, double ms, int frames, long long allocs, unsigned long long checksum) {
+    if (allocs >= 0) printf("%-22s %9.4f ms/frame  allocs %6lld  checksum %llu\n", name, ms / frames, allocs, checksum);
+    else printf("%-22s %9.4f ms/frame  checksum %llu\n", name, ms / frames, checksum);
+}
+
+static void benchRebuild(int n, int frames) {
+    Workload w(n, 12345u);
+    QuadTree qt(CustomRectangle(WORLD_W/2, WORLD_H/2, WORLD_W, WORLD_H));
+    unsigned long long checksum = 0;
+    double t0 = nowMs();
+    for (int f = 0; f < frames; f++) {
+        w.step();
+        qt.clear();
+        for (int i = 0; i < n; i++) qt.insert(w.objects[i], i);
+        checksum += runQueries(qt, w);
+    }
+    report("quadtree rebuild", nowMs() - t0, frames, qt.allocationCount(), checksum);
+}
+
+// Mismo recorrido que benchRebuild pero con todas las balas en una sola consulta por lotes
+static void benchRebuildBatch(int n, int frames) {
+    Workload w(n, 12345u);
+    QuadTree qt(CustomRectangle(WORLD_W/2, WORLD_H/2, WORLD_W, WORLD_H));
+    QueryBatch batch;
+    CustomRectangle ranges[BULLETS];
+    unsigned long long checksum = 0;
+    double t0 = nowMs();
+    for (int f = 0; f < frames; f++) {
+        w.step();
+        qt.clear();
+        for (int i = 0; i < n; i++) qt.insert(w.objects[i], i);
+        for (int b = 0; b < BULLETS; b++) ranges[b] = w.bullets[b].getBounds();
+        qt.queryBatch(ranges, BULLETS, batch);
+        for (int b = 0; b < BULLETS; b++) {
+            for (int h : batch.get(b)) checksum += (unsigned long long)(h + 1) * (unsigned long long)(b + 1) + 1;
+        }
+    }
+    report("quadtree rebuild batch", nowMs() - t0, frames, qt.allocationCount(), checksum);
+}
+
+// Solo consultas (árbol fijo) para aislar el coste del recorrido por lotes frente a uno por rango
+static void benchQueryOnly(int n, int frames, int rangeCount) {
+    Workload w(n, 12345u);
+    QuadTree qt(CustomRectangle(WORLD_W/2, WORLD_H/2, WORLD_W, WORLD_H));
+    for (int i = 0; i < n; i++) qt.insert(w.objects[i], i);
+    BenchRng rng(777u);
+    CustomRectangle* ranges = new CustomRectangle[rangeCount];
+    for (int r = 0; r < rangeCount; r++) ranges[r] = CustomRectangle(rng.range(0, WORLD_W), rng.range(0, WORLD_H), 10, 10);
+
+    unsigned long long single = 0, batched = 0;
+    double t0 = nowMs();
+    for (int f = 0; f < frames; f++) {
+        for (int r = 0; r < rangeCount; r++) {
+            for (int h : qt.queryHandles(ranges[r])) single += (unsigned long long)(h + 1) * (unsigned long long)(r + 1);
+        }
+    }
+    double t1 = nowMs();
+    QueryBatch batch;
+    for (int f = 0; f < frames; f++) {
+        qt.queryBatch(ranges, rangeCount, batch);
+        for (int r = 0; r < rangeCount; r++) {
+            for (int h : batch.get(r)) batched += (unsigned long long)(h + 1) * (unsigned long long)(r + 1);
+        }
+    }
+    double t2 = nowMs();
+    printf("%d rangos: queryHandles %.4f ms  queryBatch %.4f ms  (checksum %s)\n", rangeCount,
+           (t1 - t0) / frames, (t2 - t1) / frames, single == batched ? "igual" : "DISTINTO");
+    delete[] ranges;
+}
+
+// Como benchRebuild con el árbol lineal: insertar todo, ordenar por código Morton y consultar
+static void benchLinear(int n, int frames) {
+    Workload w(n, 12345u);
+    LinearQuadTree lt(CustomRectangle(WORLD_W/2, WORLD_H/2, WORLD_W, WORLD_H));
+    unsigned long long checksum = 0;
+    double t0 = nowMs();
+    for (int f = 0; f < frames; f++) {
+        w.step();
+        lt.clear();
+        for (int i = 0; i < n; i++) lt.insert(w.objects[i], i);
+        checksum += runQueries(lt, w);
+    }
+    report("linear rebuild", nowMs() - t0, frames, lt.allocationCount(), checksum);
+}
+
+static void benchLoose(int n, int frames) {
+    Workload w(n, 12345u);
+    LooseQuadTree lqt(CustomRectangle(WORLD_W/2, WORLD_H/2, WORLD_W, WORLD_H));
+    for (int i = 0; i < n; i++) lqt.insert(w.objects[i], i);
+    unsigned long long checksum = 0;
+    double t0 = nowMs();
+    for (int f = 0; f < frames; f++) {
+        w.step();
+        for (int i = 0; i < n; i++) lqt.update(i, w.objects[i].getBounds());
+        lqt.maintain();
+        checksum += runQueries(lqt, w);
+    }
+    report("loose incremental", nowMs() - t0, frames, lqt.allocationCount(), checksum);
+    printf("%-22s relocations/frame %.1f  nodes %d\n", "", (double)lqt.relocationCount() / frames, lqt.nodeTotal());
+}
+
+// Mismo flujo que el juego a través de la interfaz común: update por objeto, maintain y consultas
+static void benchBroadphase(const char* kind, int n, int frames) {
+    Workload w(n, 12345u);
+    Broadphase* bp = CreateBroadphase(kind, CustomRectangle(WORLD_W/2, WORLD_H/2, WORLD_W, WORLD_H));
+    for (int i = 0; i < n; i++) bp->insert(w.objects[i], i);
+    unsigned long long checksum = 0;
+    double t0 = nowMs();
+    for (int f = 0; f < frames; f++) {
+        w.step();
+        for (int i = 0; i < n; i++) bp->update(i, w.objects[i].getBounds());
+        bp->maintain();
+        for (int b = 0; b < BULLETS; b++) {
+            for (int h : bp->queryHandles(w.bullets[b].getBounds())) {
+                checksum += (unsigned long long)(h + 1) * (unsigned long long)(b + 1) + (bp->get(h).type == 2);
+            }
+        }
+    }
+    char label[64];
+    snprintf(label, sizeof(label), "broadphase %s", bp->name());
+    report(label, nowMs() - t0, frames, -1, checksum);
+    delete bp;
+}
+
+// Mismo árbol con tres cargas: el GameObject completo, una TypeTag de un byte y un árbol por tipo.
+// Las balas también van al árbol (tipo 3) y las consultas solo quieren asteroides (tipo 2).
+static void benchPayloads(int n, int frames) {
+    Workload w(n, 12345u);
+    CustomRectangle world(WORLD_W/2, WORLD_H/2, WORLD_W, WORLD_H);
+    QuadTree full(world);
+    BasicQuadTree<TypeTag, 50, 8> tagged(world);
+    TypedQuadTree<4, 50, 8> typed(world);
+    unsigned long long sums[3] = { 0, 0, 0 };
+    double ms[3] = { 0, 0, 0 };
+    for (int f = 0; f < frames; f++) {
+        w.step();
+        double t0 = nowMs();
+        full.clear();
+        for (int i = 0; i < n; i++) full.insert(w.objects[i], i);
+        for (int b = 0; b < BULLETS; b++) {
+            GameObject bullet = w.bullets[b];
+            bullet.type = 3;
+            full.insert(bullet, n + b);
+        }
+        for (int b = 0; b < BULLETS; b++) {
+            full.visit(w.bullets[b].getBounds(), [&](const GameObject& obj, int h) {
+                if (obj.type == 2) sums[0] += (unsigned long long)(h + 1) * (unsigned long long)(b + 1);
+                return true;
+            });
+        }
+        double t1 = nowMs();
+        tagged.clear();
+        for (int i = 0; i < n; i++) tagged.insert(TypeTag(2), w.objects[i].getBounds(), i);
+        for (int b = 0; b < BULLETS; b++) tagged.insert(TypeTag(3), w.bullets[b].getBounds(), n + b);
+        for (int b = 0; b < BULLETS; b++) {
+            OfType<2> asteroid;
+            tagged.visit(w.bullets[b].getBounds(), [&](const TypeTag& tag, int h) {
+                if (asteroid(tag, h)) sums[1] += (unsigned long long)(h + 1) * (unsigned long long)(b + 1);
+                return true;
+            });
+        }
+        double t2 = nowMs();
+        typed.clear();
+        for (int i = 0; i < n; i++) typed.insert(2, w.objects[i].getBounds(), i);
+        for (int b = 0; b < BULLETS; b++) typed.insert(3, w.bullets[b].getBounds(), n + b);
+        for (int b = 0; b < BULLETS; b++) {
+            typed.of<2>().visit(w.bullets[b].getBounds(), [&](const NoPayload&, int h) {
+                sums[2] += (unsigned long long)(h + 1) * (unsigned long long)(b + 1);
+                return true;
+            });
+        }
+        double t3 = nowMs();
+        ms[0] += t1 - t0; ms[1] += t2 - t1; ms[2] += t3 - t2;
+    }
+    printf("cargas: GameObject %.4f ms (%.1f KB)  TypeTag %.4f ms (%.1f KB)  un árbol por tipo %.4f ms  (checksum %s)\n",
+           ms[0] / frames, full.memoryBytes() / 1024.0, ms[1] / frames, tagged.memoryBytes() / 1024.0, ms[2] / frames,
+           sums[0] == sums[1] && sums[1] == sums[2] ? "igual" : "DISTINTO");
+}
+
+// Pares asteroide-asteroide: una consulta por asteroide (cada par sale dos veces y hay que filtrar)
+// frente al autojoin por franjas, que emite cada par una vez. Mismo checksum si encuentran los mismos pares.
+static void benchSelfJoin(int n, int frames, int threads) {
+    Workload w(n, 12345u);
+    Broadphase* bp = CreateBroadphase("loose", CustomRectangle(WORLD_W/2, WORLD_H/2, WORLD_W, WORLD_H));
+    for (int i = 0; i < n; i++) bp->insert(w.objects[i], i);
+    CustomRectangle* boxes = new CustomRectangle[n];
+    SelfJoin join(0, WORLD_H, 64.0f);
+    PairBuffer pairs;
+    JobSystem* jobs = threads > 0 ? new JobSystem(threads) : nullptr;
+
+    unsigned long long naive = 0, joined = 0;
+    long long candidates = 0, found = 0;
+    double naiveMs = 0, joinMs = 0;
+    for (int f = 0; f < frames; f++) {
+        w.step();
+        for (int i = 0; i < n; i++) bp->update(i, w.objects[i].getBounds());
+        bp->maintain();
+
+        double t0 = nowMs();
+        for (int i = 0; i < n; i++) {
+            for (int h : bp->queryHandles(w.objects[i].getBounds())) {
+                candidates++;
+                if (h > i) naive += (unsigned long long)(i + 1) * 1000003ull + (unsigned long long)(h + 1);
+            }
+        }
+        double t1 = nowMs();
+        for (int i = 0; i < n; i++) boxes[i] = w.objects[i].getBounds();
+        join.run(boxes, n, pairs, jobs);
+        for (int p = 0; p < pairs.size(); p++) {
+            joined += (unsigned long long)(pairs[p].a + 1) * 1000003ull + (unsigned long long)(pairs[p].b + 1);
+        }
+        found += pairs.size();
+        joinMs += nowMs() - t1;
+        naiveMs += t1 - t0;
+    }
+    printf("autojoin %d asteroides: consultas %.4f ms (%.0f candidatos)  autojoin %.4f ms (%.0f pares, %d hilos)  allocs %lld  (checksum %s)\n",
+           n, naiveMs / frames, (double)candidates / frames, joinMs / frames, (double)found / frames, threads,
+           join.allocationCount() + pairs.allocationCount(), naive == joined ? "igual" : "DISTINTO");
+    delete jobs;
+    delete[] boxes;
+    delete bp;
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 2000;
+    int frames = argc > 2 ? atoi(argv[2]) : 600;
+    printf("asteroides %d, frames %d, balas %d\n", n, frames, BULLETS);
+    benchRebuild(n, frames);
+    benchRebuildBatch(n, frames);
+    benchLinear(n, frames);
+    benchLoose(n, frames);
+    // La rejilla envuelve los bordes, así que su checksum incluye los choques a través del borde
+    benchBroadphase("quadtree", n, frames);
+    benchBroadphase("loose", n, frames);
+    benchBroadphase("grid", n, frames);
+    benchQueryOnly(n, frames, BULLETS);
+    benchQueryOnly(n, frames / 10 > 0 ? frames / 10 : 1, 2000);
+    benchPayloads(n, frames);
+    int selfJoinFrames = frames / 10 > 0 ? frames / 10 : 1;
+    int helpers = (int)std::thread::hardware_concurrency() - 1;
+    benchSelfJoin(n, selfJoinFrames, 0);
+    if (helpers > 0) benchSelfJoin(n, selfJoinFrames, helpers);
+    benchSelfJoin(10000, selfJoinFrames, 0);
+    benchSelfJoin(20000, selfJoinFrames, 0);
+    return 0;
+}
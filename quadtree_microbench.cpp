@@ -0,0 +1,233 @@
+// Microbenchmarks de QuadTree: insert, query y clear por separado, a varias escalas,
+// distribuciones y parámetros (capacidad de hoja y profundidad máxima).
+// Al final compara el QuadTree con el árbol lineal (orden Morton) a 2k, 20k y 200k objetos.
+// Uso: quadtree_microbench [maxObjetos]
+#include "quadtree.h"
+#include "linearquadtree.h"
+#include "rng.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// El mundo crece con n para mantener la densidad del juego (2000 asteroides en 1280x720)
+static const float BASE_W = 1280.0f;
+static const float BASE_H = 720.0f;
+static const int BASE_OBJECTS = 2000;
+static const int QUERIES = 1000;
+static const float QUERY_SIZE = 64.0f;
+static const unsigned int SEED = 12345u;
+// Tope de referencias en hojas: con hojas pequeñas y mucha profundidad la inserción en todos
+// los hijos se dispara (cada objeto acaba en miles de hojas) y la medición se corta ahí
+static const int ENTRY_LIMIT = 4000000;
+
+enum Distribution { DIST_UNIFORM, DIST_CLUSTERED, DIST_BOUNDARY };
+static const char* DIST_NAMES[] = { "uniform", "clustered", "boundary" };
+
+static double nowNs() {
+    using namespace std::chrono;
+    return duration<double, std::nano>(steady_clock::now().time_since_epoch()).count();
+}
+
+static float uniform(SimRng& rng, float lo, float hi) {
+    return lo + (hi - lo) * (float)(rng.next() & 0xFFFFFF) / 16777215.0f;
+}
+
+struct Scene {
+    int count;
+    float width, height;
+    GameObject* objects;
+    CustomRectangle queries[QUERIES];
+
+    Scene(int n, Distribution dist) : count(n) {
+        float scale = n > BASE_OBJECTS ? sqrtf((float)n / BASE_OBJECTS) : 1.0f;
+        width = BASE_W * scale;
+        height = BASE_H * scale;
+        objects = new GameObject[n];
+        SimRng rng(SEED);
+
+        // Ocho cúmulos pequeños: muchas hojas llegan a la profundidad máxima
+        Point centers[8];
+        for (int c = 0; c < 8; c++) centers[c] = Point(uniform(rng, 0, width), uniform(rng, 0, height));
+        float spread = width * 0.02f;
+
+        for (int i = 0; i < n; i++) {
+            GameObject& obj = objects[i];
+            obj.width = obj.height = (float)rng.range(1, 3) * 30.0f;
+            obj.type = 2;
+            obj.id = i;
+            if (dist == DIST_UNIFORM) {
+                obj.position = Point(uniform(rng, 0, width), uniform(rng, 0, height));
+            } else if (dist == DIST_CLUSTERED) {
+                const Point& c = centers[rng.range(0, 7)];
+                // Suma de dos uniformes: más denso en el centro del cúmulo
+                float dx = uniform(rng, -spread, spread) + uniform(rng, -spread, spread);
+                float dy = uniform(rng, -spread, spread) + uniform(rng, -spread, spread);
+                obj.position = Point(c.x + dx, c.y + dy);
+            } else {
+                // Todos sobre la frontera vertical de la raíz: cada uno cae en dos hijos en cada nivel
+                obj.position = Point(width / 2, uniform(rng, 0, height));
+            }
+        }
+        // Consultas del tamaño de una bala grande centradas en objetos al azar (siempre hay algo cerca)
+        for (int q = 0; q < QUERIES; q++) {
+            const GameObject& obj = objects[rng.range(0, n - 1)];
+            queries[q] = CustomRectangle(obj.position.x, obj.position.y, QUERY_SIZE, QUERY_SIZE);
+        }
+    }
+    ~Scene() { delete[] objects; }
+
+    CustomRectangle bounds() const { return CustomRectangle(width / 2, height / 2, width, height); }
+};
+
+struct Result {
+    bool exploded;
+    double insertNs, queryNs, clearNs;
+    int nodes, entries, objects;
+    long long peakBytes;
+    unsigned long long checksum;
+};
+
+// Capacidad y profundidad son parámetros de plantilla: una instancia del árbol por combinación
+template <int Cap, int Depth>
+static Result measure(const Scene& s) {
+    Result r;
+    BasicQuadTree<GameObject, Cap, Depth, GameObjectBounds> tree(s.bounds());
+    // Repeticiones para que cada medición cubra al menos ~200k inserciones
+    int reps = 200000 / s.count;
+    if (reps < 1) reps = 1;
+
+    double insertNs = 0, clearNs = 0;
+    r.exploded = false;
+    for (int rep = 0; rep < reps && !r.exploded; rep++) {
+        double t0 = nowNs();
+        tree.clear();
+        double t1 = nowNs();
+        for (int i = 0; i < s.count; i++) {
+            tree.insert(s.objects[i], i);
+            if (tree.entryTotal() > ENTRY_LIMIT) { r.exploded = true; break; }
+        }
+        double t2 = nowNs();
+        clearNs += t1 - t0;
+        insertNs += t2 - t1;
+    }
+    r.insertNs = insertNs / ((double)reps * s.count);
+    r.clearNs = clearNs / reps;
+    r.nodes = tree.nodeTotal();
+    r.entries = tree.entryTotal();
+    r.objects = tree.objectTotal();
+    r.peakBytes = tree.memoryBytes();
+    r.checksum = 0;
+    r.queryNs = 0;
+    if (r.exploded) return r;
+
+    // El checksum solo depende de la escena: tiene que coincidir para todos los cap/depth
+    double t0 = nowNs();
+    for (int q = 0; q < QUERIES; q++) {
+        HandleSpan hits = tree.queryHandles(s.queries[q]);
+        for (int h : hits) r.checksum += (unsigned long long)(h + 1) * (unsigned long long)(q + 1);
+    }
+    r.queryNs = (nowNs() - t0) / QUERIES;
+    return r;
+}
+
+// Reconstrucción completa (clear + insert de todo, y el ordenado en el lineal) y consultas,
+// como en cada frame del juego. Mismo checksum si los dos devuelven los mismos objetos.
+// Las consultas se mueven dentro del mundo: el QuadTree no ve la parte de un objeto que
+// sobresale de la raíz y el lineal sí, así que fuera de ella no responden igual.
+static void compareLinear(int n, Distribution dist) {
+    Scene s(n, dist);
+    CustomRectangle queries[QUERIES];
+    for (int q = 0; q < QUERIES; q++) {
+        const CustomRectangle& r = s.queries[q];
+        float x = fminf(fmaxf(r.x, r.width/2), s.width - r.width/2);
+        float y = fminf(fmaxf(r.y, r.height/2), s.height - r.height/2);
+        queries[q] = CustomRectangle(x, y, r.width, r.height);
+    }
+    QuadTree tree(s.bounds());
+    LinearQuadTree linear(s.bounds());
+    int reps = 200000 / n;
+    if (reps < 1) reps = 1;
+
+    double treeBuild = 0, linearBuild = 0;
+    for (int rep = 0; rep < reps; rep++) {
+        double t0 = nowNs();
+        tree.clear();
+        for (int i = 0; i < n; i++) tree.insert(s.objects[i], i);
+        double t1 = nowNs();
+        linear.clear();
+        for (int i = 0; i < n; i++) linear.insert(s.objects[i], i);
+        linear.build();
+        double t2 = nowNs();
+        treeBuild += t1 - t0;
+        linearBuild += t2 - t1;
+    }
+
+    unsigned long long treeSum = 0, linearSum = 0;
+    double t0 = nowNs();
+    for (int q = 0; q < QUERIES; q++) {
+        for (int h : tree.queryHandles(queries[q])) treeSum += (unsigned long long)(h + 1) * (unsigned long long)(q + 1);
+    }
+    double t1 = nowNs();
+    for (int q = 0; q < QUERIES; q++) {
+        for (int h : linear.queryHandles(queries[q])) linearSum += (unsigned long long)(h + 1) * (unsigned long long)(q + 1);
+    }
+    double t2 = nowNs();
+    printf("%7d %-9s  build %8.3f / %8.3f ms  query %7.1f / %7.1f ns  memoria %8.1f / %8.1f KB  (checksum %s)\n",
+           n, DIST_NAMES[dist], treeBuild / reps / 1e6, linearBuild / reps / 1e6,
+           (t1 - t0) / QUERIES, (t2 - t1) / QUERIES, tree.memoryBytes() / 1024.0, linear.memoryBytes() / 1024.0,
+           treeSum == linearSum ? "igual" : "DISTINTO");
+}
+
+struct Variant {
+    int cap, depth;
+    Result (*measure)(const Scene&);
+};
+
+static const Variant VARIANTS[] = {
+    { 4, 6, measure<4, 6> },     { 4, 8, measure<4, 8> },     { 4, 12, measure<4, 12> },
+    { 16, 6, measure<16, 6> },   { 16, 8, measure<16, 8> },   { 16, 12, measure<16, 12> },
+    { 50, 6, measure<50, 6> },   { 50, 8, measure<50, 8> },   { 50, 12, measure<50, 12> },
+    { 128, 6, measure<128, 6> }, { 128, 8, measure<128, 8> }, { 128, 12, measure<128, 12> },
+};
+
+int main(int argc, char** argv) {
+    int maxObjects = argc > 1 ? atoi(argv[1]) : 200000;
+    const int sizes[] = { 100, 1000, 10000, 100000 };
+
+    printf("%7s %-9s %4s %5s %10s %10s %10s %8s %9s %6s %10s %20s\n",
+           "n", "dist", "cap", "depth", "insert ns", "query ns", "clear ns",
+           "nodes", "dup", "dup/n", "peak KB", "checksum");
+    for (int n : sizes) {
+        if (n > maxObjects) break;
+        for (int d = 0; d < 3; d++) {
+            Scene scene(n, (Distribution)d);
+            for (const Variant& v : VARIANTS) {
+                int cap = v.cap, depth = v.depth;
+                Result r = v.measure(scene);
+                int dup = r.entries - r.objects;
+                if (r.exploded) {
+                    printf("%7d %-9s %4d %5d  más de %d referencias tras %d objetos (%d nodos, %.1f KB)\n",
+                           n, DIST_NAMES[d], cap, depth, ENTRY_LIMIT, r.objects, r.nodes, r.peakBytes / 1024.0);
+                    continue;
+                }
+                printf("%7d %-9s %4d %5d %10.1f %10.1f %10.1f %8d %9d %6.2f %10.1f %20llu%s\n",
+                       n, DIST_NAMES[d], cap, depth, r.insertNs, r.queryNs, r.clearNs,
+                       r.nodes, dup, (double)dup / r.objects, r.peakBytes / 1024.0, r.checksum,
+                       (cap == 50 && depth == 8) ? "  *" : "");
+            }
+        }
+    }
+    printf("* parámetros por defecto del juego (cap 50, profundidad 8)\n");
+    printf("dup: referencias extra por objetos que viven en varias hojas; peak: bytes del arena\n");
+
+    printf("\nQuadTree / lineal (Morton)\n");
+    const int linearSizes[] = { 2000, 20000, 200000 };
+    for (int n : linearSizes) {
+        if (n > maxObjects) break;
+        compareLinear(n, DIST_UNIFORM);
+        compareLinear(n, DIST_CLUSTERED);
+    }
+    return 0;
+}
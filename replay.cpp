@@ -0,0 +1,297 @@
+#include "replay.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static const char REPLAY_MAGIC[4] = { 'A', 'H', 'R', '1' };
+// La versión 2 añade el tamaño de sector tras el del mundo; la 1 se sigue leyendo sin sectores
+static const unsigned int REPLAY_VERSION = 2;
+// Magia, versión, cabecera (16 bytes de nombre y 12 campos), frames, checksum final y tramos
+static const int REPLAY_FIXED_BYTES = 4 + 4 + 16 + 12 * 4 + 3 * 4;
+static const int REPLAY_V1_FIXED_BYTES = REPLAY_FIXED_BYTES - 2 * 4;
+
+// Límites de lo que se acepta de un fichero antes de reservar nada con ello. Sobran para el juego
+// (--world 400 son 512000 px de ancho y 160000 sectores) y acotan lo que GameSim reserva por el
+// tamaño del mundo (celdas del grid, franjas del autojoin, sectores).
+static const float REPLAY_MAX_WORLD_SIDE = 1048576.0f;
+static const double REPLAY_MAX_WORLD_AREA = 274877906944.0; // 2^38 px: 2^26 celdas de 64 px
+static const double REPLAY_MAX_SECTORS = 1048576.0;
+static const int REPLAY_MAX_TICK_RATE = 1000;
+static const int REPLAY_MAX_INITIAL_ASTEROIDS = 4 * MAX_ENTITY_SLOTS;
+
+static bool validSide(float v) {
+    return std::isfinite(v) && v > 0 && v <= REPLAY_MAX_WORLD_SIDE;
+}
+
+// Cabecera leída de un fichero: todo lo que llega a las reservas de GameSim tiene que estar en rango
+static bool validHeader(const ReplayHeader& h) {
+    if (h.asteroidCapacity <= 0 || h.asteroidCapacity > MAX_ENTITY_SLOTS) return false;
+    if (h.bulletCapacity <= 0 || h.bulletCapacity > MAX_ENTITY_SLOTS) return false;
+    if (h.botCapacity <= 0 || h.botCapacity > MAX_ENTITY_SLOTS) return false;
+    if (h.tickRate < 1 || h.tickRate > REPLAY_MAX_TICK_RATE) return false;
+    if (h.bots < 0 || h.bots > h.botCapacity) return false;
+    if (h.initialAsteroids < 0 || h.initialAsteroids > REPLAY_MAX_INITIAL_ASTEROIDS) return false;
+    if (!validSide(h.width) || !validSide(h.height)) return false;
+    if ((double)h.width * h.height > REPLAY_MAX_WORLD_AREA) return false;
+    // Sin sectores los dos a 0; con sectores, una rejilla acotada (como la cuenta SectorGrid)
+    if (h.sectorWidth == 0 && h.sectorHeight == 0) return true;
+    if (!validSide(h.sectorWidth) || !validSide(h.sectorHeight)) return false;
+    return ceil((double)h.width / h.sectorWidth) * ceil((double)h.height / h.sectorHeight) <= REPLAY_MAX_SECTORS;
+}
+
+ReplayHeader::ReplayHeader()
+    : asteroidCapacity(MAX_ASTEROIDS), bulletCapacity(MAX_BULLETS), botCapacity(1),
+      tickRate(SIM_BASE_TICK_RATE), asteroidCollisions(true), width(0), height(0),
+      sectorWidth(0), sectorHeight(0), seed(1), bots(0), initialAsteroids(15) {
+    memset(broadphase, 0, sizeof(broadphase));
+    strcpy(broadphase, "loose");
+}
+
+void ReplayHeader::setConfig(const SimConfig& config, float w, float h) {
+    memset(broadphase, 0, sizeof(broadphase));
+    strncpy(broadphase, config.broadphase ? config.broadphase : "loose", sizeof(broadphase) - 1);
+    asteroidCapacity = config.asteroidCapacity;
+    bulletCapacity = config.bulletCapacity;
+    botCapacity = config.botCapacity;
+    tickRate = config.tickRate;
+    asteroidCollisions = config.asteroidCollisions;
+    width = w;
+    height = h;
+    sectorWidth = config.sectorWidth;
+    sectorHeight = config.sectorHeight;
+}
+
+SimConfig ReplayHeader::config(int workerThreads) const {
+    SimConfig c;
+    c.broadphase = broadphase;
+    c.asteroidCapacity = asteroidCapacity;
+    c.bulletCapacity = bulletCapacity;
+    c.botCapacity = botCapacity;
+    c.workerThreads = workerThreads;
+    c.tickRate = tickRate;
+    c.asteroidCollisions = asteroidCollisions;
+    c.sectorWidth = sectorWidth;
+    c.sectorHeight = sectorHeight;
+    return c;
+}
+
+Replay::Replay()
+    : codes(nullptr), checks(nullptr), frameCount(0), frameCapacity(0), lastChecksum(0) {}
+
+Replay::~Replay() {
+    delete[] codes;
+    delete[] checks;
+}
+
+void Replay::reserve(int need) {
+    if (need <= frameCapacity) return;
+    // Se duplica en long long y sin pasar de 'need' cuando duplicar no cabe en un int
+    long long cap = frameCapacity > 0 ? (long long)frameCapacity * 2 : 4096;
+    while (cap < need) cap *= 2;
+    int newCap = cap > 0x7FFFFFFF ? need : (int)cap;
+    unsigned short* newCodes = new unsigned short[newCap];
+    unsigned short* newChecks = new unsigned short[newCap];
+    for (int i = 0; i < frameCount; i++) {
+        newCodes[i] = codes[i];
+        newChecks[i] = checks[i];
+    }
+    delete[] codes;
+    delete[] checks;
+    codes = newCodes;
+    checks = newChecks;
+    frameCapacity = newCap;
+}
+
+void Replay::begin(const ReplayHeader& h) {
+    header = h;
+    frameCount = 0;
+    lastChecksum = 0;
+}
+
+void Replay::addFrame(unsigned int keys, int ticks, unsigned int checksum) {
+    reserve(frameCount + 1);
+    if (ticks < 0) ticks = 0;
+    if (ticks > 255) ticks = 255;
+    codes[frameCount] = (unsigned short)((keys & 0xFF) | ((unsigned int)ticks << 8));
+    checks[frameCount] = foldChecksum(checksum);
+    frameCount++;
+    lastChecksum = checksum;
+}
+
+static unsigned char* putU32(unsigned char* p, unsigned int v) {
+    p[0] = (unsigned char)v; p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16); p[3] = (unsigned char)(v >> 24);
+    return p + 4;
+}
+
+static unsigned char* putU16(unsigned char* p, unsigned int v) {
+    p[0] = (unsigned char)v; p[1] = (unsigned char)(v >> 8);
+    return p + 2;
+}
+
+static unsigned int floatBits(float f) {
+    unsigned int u;
+    memcpy(&u, &f, 4);
+    return u;
+}
+
+static float bitsFloat(unsigned int u) {
+    float f;
+    memcpy(&f, &u, 4);
+    return f;
+}
+
+// Lectura con límites: cualquier lectura fuera del buffer deja 'ok' a false
+struct ReplayReader {
+    const unsigned char* p;
+    const unsigned char* end;
+    bool ok;
+
+    bool need(long long n) {
+        if (!ok || end - p < n) ok = false;
+        return ok;
+    }
+    unsigned int u32() {
+        if (!need(4)) return 0;
+        unsigned int v = (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+        p += 4;
+        return v;
+    }
+    unsigned int u16() {
+        if (!need(2)) return 0;
+        unsigned int v = (unsigned int)p[0] | ((unsigned int)p[1] << 8);
+        p += 2;
+        return v;
+    }
+    unsigned int varint() {
+        unsigned int v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (!need(1)) return 0;
+            unsigned char b = *p++;
+            v |= (unsigned int)(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) return v;
+        }
+        ok = false;
+        return 0;
+    }
+};
+
+bool Replay::save(const char* path, long long* writtenBytes) const {
+    // Peor caso: un tramo por frame (2 bytes de código y 1 de longitud) más el checksum
+    long long capacity = REPLAY_FIXED_BYTES + (long long)frameCount * 5;
+    unsigned char* buffer = new unsigned char[capacity];
+    unsigned char* p = buffer;
+    memcpy(p, REPLAY_MAGIC, 4); p += 4;
+    p = putU32(p, REPLAY_VERSION);
+    memcpy(p, header.broadphase, sizeof(header.broadphase)); p += sizeof(header.broadphase);
+    p = putU32(p, (unsigned int)header.asteroidCapacity);
+    p = putU32(p, (unsigned int)header.bulletCapacity);
+    p = putU32(p, (unsigned int)header.botCapacity);
+    p = putU32(p, (unsigned int)header.tickRate);
+    p = putU32(p, header.asteroidCollisions ? 1u : 0u);
+    p = putU32(p, floatBits(header.width));
+    p = putU32(p, floatBits(header.height));
+    p = putU32(p, floatBits(header.sectorWidth));
+    p = putU32(p, floatBits(header.sectorHeight));
+    p = putU32(p, header.seed);
+    p = putU32(p, (unsigned int)header.bots);
+    p = putU32(p, (unsigned int)header.initialAsteroids);
+    p = putU32(p, (unsigned int)frameCount);
+    p = putU32(p, lastChecksum);
+    unsigned char* runCountAt = p;
+    p += 4;
+
+    // Las teclas cambian pocas veces por segundo y casi todos los frames simulan un tick:
+    // los frames seguidos con el mismo código se guardan una vez
+    unsigned int runs = 0;
+    for (int i = 0; i < frameCount; ) {
+        int j = i + 1;
+        while (j < frameCount && codes[j] == codes[i]) j++;
+        p = putU16(p, codes[i]);
+        unsigned int len = (unsigned int)(j - i);
+        while (len >= 0x80) { *p++ = (unsigned char)(len | 0x80); len >>= 7; }
+        *p++ = (unsigned char)len;
+        runs++;
+        i = j;
+    }
+    putU32(runCountAt, runs);
+    for (int i = 0; i < frameCount; i++) p = putU16(p, checks[i]);
+
+    long long size = p - buffer;
+    FILE* f = fopen(path, "wb");
+    bool ok = false;
+    if (f) {
+        ok = fwrite(buffer, 1, (size_t)size, f) == (size_t)size;
+        ok = (fclose(f) == 0) && ok;
+    }
+    delete[] buffer;
+    if (ok && writtenBytes) *writtenBytes = size;
+    return ok;
+}
+
+bool Replay::load(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < REPLAY_V1_FIXED_BYTES) {
+        fclose(f);
+        return false;
+    }
+    unsigned char* data = new unsigned char[size];
+    bool ok = fread(data, 1, (size_t)size, f) == (size_t)size;
+    fclose(f);
+
+    ReplayReader in = { data, data + size, ok };
+    ok = ok && memcmp(data, REPLAY_MAGIC, 4) == 0;
+    in.p += 4;
+    unsigned int version = in.u32();
+    ok = ok && (version == 1 || version == REPLAY_VERSION);
+    ReplayHeader h;
+    if (ok) {
+        memcpy(h.broadphase, in.p, sizeof(h.broadphase));
+        h.broadphase[sizeof(h.broadphase) - 1] = 0;
+        in.p += sizeof(h.broadphase);
+        h.asteroidCapacity = (int)in.u32();
+        h.bulletCapacity = (int)in.u32();
+        h.botCapacity = (int)in.u32();
+        h.tickRate = (int)in.u32();
+        h.asteroidCollisions = in.u32() != 0;
+        h.width = bitsFloat(in.u32());
+        h.height = bitsFloat(in.u32());
+        if (version >= 2) {
+            h.sectorWidth = bitsFloat(in.u32());
+            h.sectorHeight = bitsFloat(in.u32());
+        }
+        h.seed = in.u32();
+        h.bots = (int)in.u32();
+        h.initialAsteroids = (int)in.u32();
+    }
+    int count = (int)in.u32();
+    unsigned int checksum = in.u32();
+    unsigned int runs = in.u32();
+    ok = ok && in.ok && count >= 0 && validHeader(h);
+    // Solo los checksums por frame ya ocupan 2 bytes: un recuento mayor es un fichero corrupto,
+    // y así no se reserva memoria por un número que no se ha validado
+    ok = ok && count <= (in.end - in.p) / 2;
+
+    if (ok) {
+        begin(h);
+        reserve(count);
+        for (unsigned int r = 0; r < runs && in.ok; r++) {
+            unsigned short code = (unsigned short)in.u16();
+            unsigned int len = in.varint();
+            if (len > (unsigned int)(count - frameCount)) { in.ok = false; break; }
+            for (unsigned int i = 0; i < len; i++) codes[frameCount++] = code;
+        }
+        ok = in.ok && frameCount == count;
+        for (int i = 0; ok && i < count; i++) checks[i] = (unsigned short)in.u16();
+        ok = ok && in.ok;
+        lastChecksum = checksum;
+    }
+    delete[] data;
+    if (!ok) frameCount = 0;
+    return ok;
+}
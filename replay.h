@@ -0,0 +1,75 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "simulation.h"
+
+// Grabación de una partida: la configuración de GameSim, la semilla que salió de GetRandomValue,
+// el modo (bots) y las teclas de cada frame con los ticks que simuló. Con eso la partida se
+// repite tick a tick sin ventana. Tras cada frame se guardan 16 bits del checksum del estado
+// para localizar el primer frame que diverge.
+//
+// Formato (little endian): "AHR1", versión, cabecera, número de frames, checksum final,
+// número de tramos, tramos (código de 16 bits del frame y frames seguidos iguales en LEB128)
+// y los checksums de 16 bits de cada frame.
+
+// Teclas que mira la partida, una por bit. W/A/S/D mantenidas; Q, ESC y ENTER pulsadas en ese frame
+enum InputKey {
+    INPUT_W = 1, INPUT_A = 2, INPUT_S = 4, INPUT_D = 8,
+    INPUT_Q = 16, INPUT_ESC = 32, INPUT_ENTER = 64
+};
+
+struct ReplayHeader {
+    char broadphase[16];
+    int asteroidCapacity;
+    int bulletCapacity;
+    int botCapacity;
+    int tickRate;
+    bool asteroidCollisions;
+    float width, height;
+    float sectorWidth, sectorHeight; // 0 = mundo sin sectores (y en las grabaciones de la versión 1)
+    unsigned int seed;
+    int bots;             // bots de la partida: 0 en modo solo
+    int initialAsteroids;
+
+    ReplayHeader();
+    // Copia lo que afecta al resultado; los hilos no, la simulación es determinista con cualquier número
+    void setConfig(const SimConfig& config, float w, float h);
+    // 'broadphase' apunta a esta cabecera: tiene que seguir viva mientras se use la configuración
+    SimConfig config(int workerThreads) const;
+};
+
+class Replay {
+private:
+    unsigned short* codes;  // teclas | ticks << 8, uno por frame
+    unsigned short* checks; // checksum plegado a 16 bits tras cada frame
+    int frameCount, frameCapacity;
+    unsigned int lastChecksum;
+
+    void reserve(int need);
+
+    Replay(const Replay&) = delete;
+    Replay& operator=(const Replay&) = delete;
+public:
+    ReplayHeader header;
+
+    Replay();
+    ~Replay();
+
+    // Empieza una grabación nueva; los buffers se reutilizan
+    void begin(const ReplayHeader& h);
+    void addFrame(unsigned int keys, int ticks, unsigned int checksum);
+
+    int frames() const { return frameCount; }
+    unsigned int keys(int frame) const { return codes[frame] & 0xFF; }
+    int ticks(int frame) const { return codes[frame] >> 8; }
+    unsigned short check(int frame) const { return checks[frame]; }
+    unsigned int finalChecksum() const { return lastChecksum; }
+
+    static unsigned short foldChecksum(unsigned int checksum) { return (unsigned short)(checksum ^ (checksum >> 16)); }
+
+    // Devuelve false si no se pudo escribir o si el fichero no es una grabación válida
+    bool save(const char* path, long long* writtenBytes = nullptr) const;
+    bool load(const char* path);
+};
+
+#endif
@@ -0,0 +1,69 @@
+// Reproduce sin ventana una partida grabada por el juego (last_game.replay), tan rápido como se
+// pueda, y comprueba el checksum de cada frame. Con la misma grabación se comparan compilaciones.
+// Uso: replay_player <grabación> [hilos auxiliares] [pasadas]
+//      replay_player --scripted <salida> [frames] [semilla] [broadphase] [bots]
+// La segunda forma graba una partida guionizada con frames de duración irregular (incluye una
+// pausa) hasta 'frames' o hasta que acabe, para tener una grabación de referencia sin abrir el juego.
+#include "session.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const float WORLD_W = 1280.0f;
+static const float WORLD_H = 720.0f;
+
+static int recordScripted(const char* path, int frames, unsigned int seed, const char* broadphase, int bots) {
+    SimConfig config;
+    config.broadphase = broadphase;
+    config.botCapacity = bots > 0 ? bots : 1;
+    config.bulletCapacity = MAX_BULLETS + BULLETS_PER_BOT * config.botCapacity;
+    config.workerThreads = 0;
+    GameSim sim(WORLD_W, WORLD_H, config);
+    GameSession session(&sim, config.tickRate);
+    Replay replay;
+    session.setRecording(&replay, config);
+    session.start(seed, bots);
+    session.state = GAME_PLAYING;
+
+    // Frames de 60 Hz con ruido, alguno de 144 Hz y tirones de 50 ms: 0, 1 o varios ticks por frame
+    SimRng rng(seed ^ 0x5EEDu);
+    unsigned int held = 0;
+    for (int f = 0; f < frames && session.state != GAME_MENU; f++) {
+        if (f % 30 == 0) held = rng.next() & (INPUT_W | INPUT_A | INPUT_S | INPUT_D);
+        unsigned int keys = held;
+        if (f % 8 == 0) keys |= INPUT_Q;
+        // Una pausa de medio segundo a mitad de partida
+        if (f == frames / 2 || f == frames / 2 + 30) keys |= INPUT_ESC;
+        if (session.state == GAME_OVER) keys = INPUT_ENTER;
+        unsigned int r = rng.next() % 100;
+        double frameTime = r < 5 ? 0.05 : (r < 25 ? 1.0 / 144 : 1.0 / 60 + (double)(r % 7) * 0.0005);
+        session.frame(keys, frameTime);
+    }
+
+    long long bytes = 0;
+    if (!replay.save(path, &bytes)) {
+        fprintf(stderr, "no se pudo escribir %s\n", path);
+        return 1;
+    }
+    printf("%s: %d frames, %lld bytes, checksum %08x\n", path, replay.frames(), bytes, replay.finalChecksum());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 2 && strcmp(argv[1], "--scripted") == 0) {
+        int frames = argc > 3 ? atoi(argv[3]) : 7200;
+        unsigned int seed = argc > 4 ? (unsigned int)strtoul(argv[4], nullptr, 10) : 12345u;
+        const char* broadphase = argc > 5 ? argv[5] : "loose";
+        int bots = argc > 6 ? atoi(argv[6]) : 1;
+        return recordScripted(argv[2], frames, seed, broadphase, bots);
+    }
+    if (argc < 2) {
+        fprintf(stderr, "uso: %s <grabación> [hilos auxiliares] [pasadas]\n"
+                        "     %s --scripted <salida> [frames] [semilla] [broadphase] [bots]\n", argv[0], argv[0]);
+        return 1;
+    }
+    int workers = argc > 2 ? atoi(argv[2]) : JobSystem::defaultWorkers();
+    int passes = argc > 3 ? atoi(argv[3]) : 3;
+    return PlayReplayFile(argv[1], workers, passes);
+}
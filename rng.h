@@ -0,0 +1,25 @@
+#ifndef RNG_H
+#define RNG_H
+
+// Generador xorshift32 con semilla propia: la simulación es reproducible sin GetRandomValue
+struct SimRng {
+    unsigned int state;
+
+    explicit SimRng(unsigned int s = 1) { seed(s); }
+    void seed(unsigned int s) { state = s ? s : 0x9E3779B9u; }
+
+    unsigned int next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    // Entero en [min, max], mismo contrato que GetRandomValue
+    int range(int min, int max) {
+        if (min > max) { int t = min; min = max; max = t; }
+        unsigned int span = (unsigned int)(max - min) + 1u;
+        return min + (int)(next() % span);
+    }
+};
+
+#endif
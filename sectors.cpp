@@ -0,0 +1,137 @@
+#include "sectors.h"
+
+#include <algorithm>
+
+// Semiextensiones de las áreas de un foco, en sectores. Con sectores del tamaño de la pantalla la
+// vista (medio sector a cada lado) queda dentro del área de despertar con medio sector de margen.
+static const float SECTOR_WAKE_RADIUS = 1.0f;
+static const float SECTOR_KEEP_RADIUS = 1.5f;
+
+SectorGrid::SectorGrid(float w, float h, float sectorWidth, float sectorHeight)
+    : worldW(w), worldH(h), touchedCount(0), activeCount(0), dormant(0), allocations(0) {
+    cols = (int)ceilf(w / sectorWidth);
+    rows = (int)ceilf(h / sectorHeight);
+    if (cols < 1) cols = 1;
+    if (rows < 1) rows = 1;
+    // Los sectores cubren el mundo exacto: el último no queda más pequeño
+    sectorW = w / (float)cols;
+    sectorH = h / (float)rows;
+    int n = cols * rows;
+    sectors = new Sector[n];
+    for (int i = 0; i < n; i++) {
+        Sector& s = sectors[i];
+        s.x = s.y = s.vx = s.vy = nullptr;
+        s.size = s.since = nullptr;
+        s.count = s.capacity = 0;
+        s.active = false;
+    }
+    wanted = new unsigned char[n];
+    for (int i = 0; i < n; i++) wanted[i] = 0;
+    touched = new int[n];
+    activeList = new int[n];
+}
+
+SectorGrid::~SectorGrid() {
+    for (int i = 0; i < cols * rows; i++) {
+        Sector& s = sectors[i];
+        delete[] s.x; delete[] s.y; delete[] s.vx; delete[] s.vy;
+        delete[] s.size; delete[] s.since;
+    }
+    delete[] sectors;
+    delete[] wanted;
+    delete[] touched;
+    delete[] activeList;
+}
+
+void SectorGrid::grow(Sector& s, int need) {
+    int newCap = s.capacity > 0 ? s.capacity * 2 : 64;
+    while (newCap < need) newCap *= 2;
+    float* nx = new float[newCap];
+    float* ny = new float[newCap];
+    float* nvx = new float[newCap];
+    float* nvy = new float[newCap];
+    int* nsize = new int[newCap];
+    int* nsince = new int[newCap];
+    for (int i = 0; i < s.count; i++) {
+        nx[i] = s.x[i]; ny[i] = s.y[i];
+        nvx[i] = s.vx[i]; nvy[i] = s.vy[i];
+        nsize[i] = s.size[i]; nsince[i] = s.since[i];
+    }
+    delete[] s.x; delete[] s.y; delete[] s.vx; delete[] s.vy;
+    delete[] s.size; delete[] s.since;
+    s.x = nx; s.y = ny; s.vx = nvx; s.vy = nvy;
+    s.size = nsize; s.since = nsince;
+    s.capacity = newCap;
+    allocations++;
+}
+
+int SectorGrid::sectorOf(float x, float y) const {
+    int c = (int)(x / sectorW);
+    int r = (int)(y / sectorH);
+    if (c < 0) c = 0; else if (c >= cols) c = cols - 1;
+    if (r < 0) r = 0; else if (r >= rows) r = rows - 1;
+    return r * cols + c;
+}
+
+void SectorGrid::clear() {
+    for (int i = 0; i < cols * rows; i++) {
+        sectors[i].count = 0;
+        sectors[i].active = false;
+    }
+    activeCount = 0;
+    dormant = 0;
+}
+
+void SectorGrid::store(int sector, float x, float y, float vx, float vy, int size, int tick) {
+    Sector& s = sectors[sector];
+    if (s.count == s.capacity) grow(s, s.count + 1);
+    int k = s.count++;
+    s.x[k] = x; s.y[k] = y;
+    s.vx[k] = vx; s.vy[k] = vy;
+    s.size[k] = size;
+    s.since[k] = tick;
+    dormant++;
+}
+
+void SectorGrid::beginFocus() {
+    for (int i = 0; i < touchedCount; i++) wanted[touched[i]] = 0;
+    touchedCount = 0;
+}
+
+void SectorGrid::mark(float cx, float cy, float halfW, float halfH, unsigned char bit) {
+    // Columnas y filas que toca el área, dando la vuelta al mundo por los bordes
+    int c0 = (int)floorf((cx - halfW) / sectorW), c1 = (int)floorf((cx + halfW) / sectorW);
+    int r0 = (int)floorf((cy - halfH) / sectorH), r1 = (int)floorf((cy + halfH) / sectorH);
+    if (c1 - c0 >= cols) { c0 = 0; c1 = cols - 1; }
+    if (r1 - r0 >= rows) { r0 = 0; r1 = rows - 1; }
+    for (int r = r0; r <= r1; r++) {
+        int row = ((r % rows) + rows) % rows;
+        for (int c = c0; c <= c1; c++) {
+            int col = ((c % cols) + cols) % cols;
+            int i = row * cols + col;
+            if (wanted[i] == 0) touched[touchedCount++] = i;
+            wanted[i] |= bit;
+        }
+    }
+}
+
+void SectorGrid::addFocus(float x, float y) {
+    mark(x, y, sectorW * SECTOR_WAKE_RADIUS, sectorH * SECTOR_WAKE_RADIUS, 1);
+    mark(x, y, sectorW * SECTOR_KEEP_RADIUS, sectorH * SECTOR_KEEP_RADIUS, 2);
+}
+
+void SectorGrid::updateActive() {
+    // Se duermen los activos fuera de toda área de mantener; los que siguen activos están en 'touched'
+    for (int n = 0; n < activeCount; n++) {
+        int i = activeList[n];
+        if ((wanted[i] & 2) == 0) sectors[i].active = false;
+    }
+    activeCount = 0;
+    for (int n = 0; n < touchedCount; n++) {
+        int i = touched[n];
+        Sector& s = sectors[i];
+        if (!s.active && (wanted[i] & 1)) s.active = true;
+        if (s.active) activeList[activeCount++] = i;
+    }
+    std::sort(activeList, activeList + activeCount);
+}
@@ -0,0 +1,99 @@
+#ifndef SECTORS_H
+#define SECTORS_H
+
+#include <cmath>
+
+// Mundo más grande que la pantalla repartido en una rejilla de sectores. Solo los sectores cerca
+// de un foco (la nave, los bots) están en la simulación; los asteroides de los demás duermen aquí
+// en SoA, fuera de GameSim y del broadphase, con el tick en que se durmieron. Al despertar un
+// sector se adelantan de golpe los ticks que faltan: movimiento lineal envuelto dentro del propio
+// sector y sin choques, así que dormir cuesta memoria y nada por tick.
+// Un sector despierta cuando toca el área de despertar de un foco y se duerme cuando deja de tocar
+// el área de mantener, algo mayor: ir y venir por un borde no los duerme y despierta en cada tick.
+// Por tick solo se miran los sectores alrededor de los focos: el coste no crece con el mundo.
+class SectorGrid {
+private:
+    struct Sector {
+        float* x;
+        float* y;
+        float* vx;
+        float* vy;
+        int* size;
+        int* since;     // tick en que se durmió cada asteroide
+        int count, capacity;
+        bool active;    // sus asteroides están en la simulación
+    };
+
+    float worldW, worldH;
+    float sectorW, sectorH;
+    int cols, rows;
+    Sector* sectors;
+    unsigned char* wanted;  // bit 0: dentro del área de despertar; bit 1: dentro de la de mantener
+    int* touched;           // sectores con algún bit en 'wanted': lo único que se recorre por tick
+    int touchedCount;
+    int* activeList;        // sectores activos, en orden de índice
+    int activeCount;
+    long long dormant;
+    long long allocations;
+
+    void grow(Sector& s, int need);
+    void mark(float cx, float cy, float halfW, float halfH, unsigned char bit);
+
+    SectorGrid(const SectorGrid&) = delete;
+    SectorGrid& operator=(const SectorGrid&) = delete;
+public:
+    SectorGrid(float w, float h, float sectorWidth, float sectorHeight);
+    ~SectorGrid();
+
+    int sectorCount() const { return cols * rows; }
+    int sectorOf(float x, float y) const;
+    bool isActive(int sector) const { return sectors[sector].active; }
+    int activeSectors() const { return activeCount; }
+    int activeSector(int n) const { return activeList[n]; }
+    long long dormantCount() const { return dormant; }
+    long long allocationCount() const { return allocations; }
+
+    // Todos dormidos y vacíos
+    void clear();
+    // Duerme un asteroide en 'sector' con su estado del tick 'tick'
+    void store(int sector, float x, float y, float vx, float vy, int size, int tick);
+
+    // Focos del tick: beginFocus, un addFocus por foco y updateActive. Las áreas envuelven el mundo.
+    void beginFocus();
+    void addFocus(float x, float y);
+    // Activa los que tocan un área de despertar y duerme los que no tocan ninguna de mantener
+    void updateActive();
+
+    // Despierta los dormidos de 'sector' en orden, adelantados al tick 'now' con 'scale' píxeles
+    // de velocidad por tick. wakeFn(x, y, vx, vy, size) devuelve false si ya no caben: los que
+    // quedan siguen dormidos (sin adelantar) para el siguiente intento.
+    template <typename WakeFn>
+    void wake(int sector, int now, float scale, WakeFn wakeFn);
+};
+
+template <typename WakeFn>
+void SectorGrid::wake(int sector, int now, float scale, WakeFn wakeFn) {
+    Sector& s = sectors[sector];
+    float x0 = (float)(sector % cols) * sectorW;
+    float y0 = (float)(sector / cols) * sectorH;
+    int k = 0;
+    for (; k < s.count; k++) {
+        float n = (float)(now - s.since[k]) * scale;
+        float dx = fmodf(s.x[k] + s.vx[k] * n - x0, sectorW);
+        float dy = fmodf(s.y[k] + s.vy[k] * n - y0, sectorH);
+        if (dx < 0) dx += sectorW;
+        if (dy < 0) dy += sectorH;
+        if (!wakeFn(x0 + dx, y0 + dy, s.vx[k], s.vy[k], s.size[k])) break;
+    }
+    // Los que no cupieron pasan al principio
+    int left = s.count - k;
+    for (int i = 0; i < left; i++) {
+        s.x[i] = s.x[k + i]; s.y[i] = s.y[k + i];
+        s.vx[i] = s.vx[k + i]; s.vy[i] = s.vy[k + i];
+        s.size[i] = s.size[k + i]; s.since[i] = s.since[k + i];
+    }
+    dormant -= k;
+    s.count = left;
+}
+
+#endif
@@ -0,0 +1,124 @@
+#include "selfjoin.h"
+#include "jobs.h"
+
+#include <algorithm>
+#include <cmath>
+
+PairBuffer::PairBuffer() : pairs(nullptr), pairCount(0), pairCapacity(0), allocations(0) {}
+
+PairBuffer::~PairBuffer() {
+    delete[] pairs;
+}
+
+void PairBuffer::grow(int need) {
+    int newCap = pairCapacity > 0 ? pairCapacity * 2 : 256;
+    while (newCap < need) newCap *= 2;
+    OverlapPair* newPairs = new OverlapPair[newCap];
+    for (int i = 0; i < pairCount; i++) newPairs[i] = pairs[i];
+    delete[] pairs;
+    pairs = newPairs;
+    pairCapacity = newCap;
+    allocations++;
+}
+
+void PairBuffer::append(const PairBuffer& other) {
+    if (pairCount + other.pairCount > pairCapacity) grow(pairCount + other.pairCount);
+    for (int i = 0; i < other.pairCount; i++) pairs[pairCount + i] = other.pairs[i];
+    pairCount += other.pairCount;
+}
+
+SelfJoin::SelfJoin(float y, float height, float stripSize)
+    : originY(y), stripHeight(stripSize > 0 ? stripSize : 64.0f),
+      entries(nullptr), entryCapacity(0), allocations(0) {
+    stripCount = (int)ceilf(height / stripHeight);
+    if (stripCount < 1) stripCount = 1;
+    stripStart = new int[stripCount + 1];
+    stripCursor = new int[stripCount];
+    stripPairs = new PairBuffer[stripCount];
+}
+
+SelfJoin::~SelfJoin() {
+    delete[] stripStart;
+    delete[] stripCursor;
+    delete[] entries;
+    delete[] stripPairs;
+}
+
+int SelfJoin::stripOf(float y) const {
+    int s = (int)floorf((y - originY) / stripHeight);
+    return s < 0 ? 0 : (s >= stripCount ? stripCount - 1 : s);
+}
+
+void SelfJoin::sweepStrip(int strip, const CustomRectangle* boxes) {
+    PairBuffer& out = stripPairs[strip];
+    out.clear();
+    Entry* first = entries + stripStart[strip];
+    int count = stripStart[strip + 1] - stripStart[strip];
+    // Empates por índice de caja: el orden (y la salida) es siempre el mismo
+    std::sort(first, first + count, [](const Entry& a, const Entry& b) {
+        return a.minX < b.minX || (a.minX == b.minX && a.box < b.box);
+    });
+
+    for (int i = 0; i < count; i++) {
+        const CustomRectangle& a = boxes[first[i].box];
+        float maxX = a.x + a.width/2;
+        float minYa = a.y - a.height/2, maxYa = a.y + a.height/2;
+        // Ordenadas por x mínima: en cuanto una empieza después de 'maxX', las siguientes también
+        for (int j = i + 1; j < count && first[j].minX <= maxX; j++) {
+            const CustomRectangle& b = boxes[first[j].box];
+            float minYb = b.y - b.height/2, maxYb = b.y + b.height/2;
+            if (minYb > maxYa || minYa > maxYb) continue;
+            // Solo la franja donde empieza el solape en y emite el par
+            if (stripOf(minYa > minYb ? minYa : minYb) != strip) continue;
+            int ia = first[i].box, ib = first[j].box;
+            if (ia < ib) out.add(ia, ib);
+            else out.add(ib, ia);
+        }
+    }
+}
+
+void SelfJoin::run(const CustomRectangle* boxes, int n, PairBuffer& out, JobSystem* jobs) {
+    out.clear();
+    // Counting sort de las cajas por franja (una entrada por franja que cubren)
+    for (int s = 0; s <= stripCount; s++) stripStart[s] = 0;
+    for (int i = 0; i < n; i++) {
+        int s0 = stripOf(boxes[i].y - boxes[i].height/2);
+        int s1 = stripOf(boxes[i].y + boxes[i].height/2);
+        for (int s = s0; s <= s1; s++) stripStart[s + 1]++;
+    }
+    for (int s = 0; s < stripCount; s++) stripStart[s + 1] += stripStart[s];
+    int total = stripStart[stripCount];
+    if (total > entryCapacity) {
+        int newCap = entryCapacity > 0 ? entryCapacity : 256;
+        while (newCap < total) newCap *= 2;
+        delete[] entries;
+        entries = new Entry[newCap];
+        entryCapacity = newCap;
+        allocations++;
+    }
+    for (int s = 0; s < stripCount; s++) stripCursor[s] = stripStart[s];
+    for (int i = 0; i < n; i++) {
+        int s0 = stripOf(boxes[i].y - boxes[i].height/2);
+        int s1 = stripOf(boxes[i].y + boxes[i].height/2);
+        for (int s = s0; s <= s1; s++) {
+            Entry& e = entries[stripCursor[s]++];
+            e.minX = boxes[i].x - boxes[i].width/2;
+            e.box = i;
+        }
+    }
+
+    if (jobs) {
+        jobs->parallelFor(stripCount, 1, [this, boxes](int begin, int end, int) {
+            for (int s = begin; s < end; s++) sweepStrip(s, boxes);
+        });
+    } else {
+        for (int s = 0; s < stripCount; s++) sweepStrip(s, boxes);
+    }
+    for (int s = 0; s < stripCount; s++) out.append(stripPairs[s]);
+}
+
+long long SelfJoin::allocationCount() const {
+    long long total = allocations;
+    for (int s = 0; s < stripCount; s++) total += stripPairs[s].allocationCount();
+    return total;
+}
@@ -0,0 +1,80 @@
+#ifndef SELFJOIN_H
+#define SELFJOIN_H
+
+#include "quadtree.h"
+
+// Par de cajas que se solapan: índices en el arreglo de entrada, siempre a < b
+struct OverlapPair {
+    int a, b;
+};
+
+// Buffer de pares reutilizable: clear() conserva la memoria entre frames
+class PairBuffer {
+private:
+    OverlapPair* pairs;
+    int pairCount, pairCapacity;
+    long long allocations;
+
+    void grow(int need);
+
+    PairBuffer(const PairBuffer&) = delete;
+    PairBuffer& operator=(const PairBuffer&) = delete;
+public:
+    PairBuffer();
+    ~PairBuffer();
+    void clear() { pairCount = 0; }
+    void add(int a, int b) {
+        if (pairCount == pairCapacity) grow(pairCount + 1);
+        pairs[pairCount].a = a;
+        pairs[pairCount].b = b;
+        pairCount++;
+    }
+    // Añade todos los pares de 'other' al final
+    void append(const PairBuffer& other);
+    int size() const { return pairCount; }
+    const OverlapPair& operator[](int i) const { return pairs[i]; }
+    long long allocationCount() const { return allocations; }
+};
+
+// Autojoin de cajas: todos los pares que se solapan, cada uno una sola vez.
+// Barrido y poda por franjas horizontales: cada caja entra en las franjas que cubre, dentro de
+// cada franja se ordena por x mínima y se barre comparando solo con las que aún pueden solaparse
+// en x. Un par se emite solo en la franja donde empieza su solape en y, así que las cajas que
+// cruzan dos franjas no lo repiten. Las franjas son independientes y se reparten entre hilos;
+// el resultado (y su orden) no depende de cuántos haya.
+class SelfJoin {
+private:
+    struct Entry {
+        float minX;
+        int box;
+    };
+
+    float originY;
+    float stripHeight;
+    int stripCount;
+    int* stripStart;     // stripCount + 1 entradas: inicio de cada franja en 'entries'
+    int* stripCursor;
+    Entry* entries;
+    int entryCapacity;
+    PairBuffer* stripPairs;  // salida de cada franja antes de unirlas en orden
+    long long allocations;
+
+    int stripOf(float y) const;
+    void sweepStrip(int strip, const CustomRectangle* boxes);
+
+    SelfJoin(const SelfJoin&) = delete;
+    SelfJoin& operator=(const SelfJoin&) = delete;
+public:
+    // Franjas de 'stripSize' de alto sobre [y, y + height]. Con franjas al menos tan altas como
+    // la caja más alta, cada caja cae en una o dos. Lo que sale del rango va a la primera o la última.
+    SelfJoin(float y, float height, float stripSize = 64.0f);
+    ~SelfJoin();
+
+    // Escribe en 'out' los pares que se solapan (bordes incluidos, como CustomRectangle::intersects).
+    // 'jobs' reparte las franjas (nullptr = hilo actual).
+    void run(const CustomRectangle* boxes, int n, PairBuffer& out, JobSystem* jobs = nullptr);
+
+    long long allocationCount() const;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "simulation.h"
+#include "replay.h"
+
+// Una partida sin raylib: estado (jugando, en pausa, terminada), reloj de paso fijo y teclas de
+// cada frame. El juego le pasa lo que lee del teclado y la reproducción lo que se grabó, así que
+// las dos recorren el mismo camino hasta GameSim::step.
+
+enum GameState { GAME_MENU, GAME_PLAYING, GAME_PAUSED, GAME_OVER };
+
+const int WIN_SCORE = 2500;
+const int INITIAL_ASTEROIDS = 15;
+
+class GameSession {
+private:
+    GameSim* sim;
+    FixedTimestep clock;
+    bool firePending; // un disparo pulsado en un frame sin ticks espera al siguiente tick
+    Replay* recording;
+    ReplayHeader recordHeader;
+public:
+    GameState state;
+    bool playerWon;
+    // Eventos del último frame: el juego los convierte en sonidos
+    int shots, hits;
+
+    GameSession(GameSim* gameSim, int tickRate);
+    // Graba en 'replay' las partidas que empiecen a partir de ahora (nullptr: no graba).
+    // 'config' es la que se usó para crear la simulación.
+    void setRecording(Replay* replay, const SimConfig& config);
+    // Partida nueva con 'bots' bots (0 en modo solo); la grabación empieza de cero. No cambia 'state'.
+    void start(unsigned int seed, int bots, int initialAsteroids = INITIAL_ASTEROIDS);
+    // Un frame fuera del menú con las teclas de ese frame (InputKey). Los ticks los decide el
+    // reloj con 'frameTime'; con recordedTicks >= 0 se simulan esos (reproducción).
+    void frame(unsigned int keys, double frameTime, int recordedTicks = -1);
+    // Fracción del siguiente tick para interpolar el dibujo
+    float alpha() const { return clock.alpha(); }
+};
+
+struct PlaybackResult {
+    int frames;
+    long long ticks;
+    int divergedFrame;     // primer frame cuyo checksum no coincide, o -1
+    unsigned int finalChecksum;
+    double totalMs;        // solo simulación: sin cargar el fichero ni comprobar checksums
+    double p50, p95, p99, worst; // ms por frame con ticks
+};
+
+// Repite la grabación sin ventana, tan rápido como se pueda. Devuelve false si diverge.
+bool PlayReplay(const Replay& replay, int workerThreads, PlaybackResult& result);
+// Carga 'path', la reproduce 'passes' veces e imprime tiempos y checksums.
+// Código de salida para main: 0 si todo coincide.
+int PlayReplayFile(const char* path, int workerThreads, int passes);
+
+#endif
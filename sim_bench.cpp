@@ -0,0 +1,143 @@
+// Bucle del juego sin ventana: misma simulación que asteroid.cpp con entradas guionizadas.
+// Uso: sim_bench [ticks] [semilla] [asteroides] [broadphase] [bots] [hilos auxiliares] [ticks/s]
+//                [pantallas por lado]
+// Con más de una pantalla por lado el mundo va por sectores de una pantalla y 'asteroides' son
+// los de todo el mundo: solo se simulan los de los sectores cerca de la nave y los bots.
+#include "simulation.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+static const float WORLD_W = 1280.0f;
+static const float WORLD_H = 720.0f;
+
+// Jugador guionizado: cambia de dirección cada 30 ticks y dispara cada 8.
+// Usa su propio generador para no alterar la secuencia de la simulación.
+struct ScriptedPlayer {
+    SimRng rng;
+    unsigned int held;
+
+    explicit ScriptedPlayer(unsigned int seed) : rng(seed ^ 0xA5A5A5A5u), held(0) {}
+    SimInput next(int tick) {
+        if (tick % 30 == 0) held = rng.next() & (SIM_UP | SIM_DOWN | SIM_LEFT | SIM_RIGHT);
+        unsigned int buttons = held;
+        if (tick % 8 == 0) buttons |= SIM_FIRE;
+        return SimInput(buttons);
+    }
+};
+
+struct RunResult {
+    double ms;
+    unsigned int checksum;
+    int asteroids;
+    long long dormant;
+    int activeSectors;
+    int playerScore, botScore;
+};
+
+static RunResult run(int ticks, unsigned int seed, int initial, const char* broadphase, int bots, int workers,
+                     int tickRate, int screens) {
+    SimConfig config;
+    config.broadphase = broadphase;
+    // Cada asteroide grande puede acabar en 6 fragmentos vivos a la vez
+    int awake = initial;
+    if (screens > 1) {
+        // Despiertos: hasta 3x3 sectores alrededor de cada foco (la nave y los bots, sin contar solapes)
+        config.sectorWidth = WORLD_W;
+        config.sectorHeight = WORLD_H;
+        long long perSector = ((long long)initial + screens * screens - 1) / ((long long)screens * screens);
+        long long sectorsAwake = 9LL * (1 + bots);
+        if (sectorsAwake > (long long)screens * screens) sectorsAwake = (long long)screens * screens;
+        awake = (int)(perSector * sectorsAwake);
+    }
+    config.asteroidCapacity = awake * 7 > MAX_ASTEROIDS ? awake * 7 : MAX_ASTEROIDS;
+    config.bulletCapacity = MAX_BULLETS + BULLETS_PER_BOT * bots;
+    config.botCapacity = bots;
+    config.workerThreads = workers;
+    config.tickRate = tickRate;
+    GameSim sim(WORLD_W * screens, WORLD_H * screens, config);
+    sim.reset(seed, bots, initial);
+    ScriptedPlayer player(seed);
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int t = 0; t < ticks; t++) sim.step(player.next(t));
+    auto t1 = std::chrono::steady_clock::now();
+
+    RunResult r;
+    r.ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    r.checksum = sim.checksum();
+    r.asteroids = sim.asteroids.count;
+    r.dormant = sim.dormantAsteroids();
+    r.activeSectors = sim.activeSectors();
+    r.playerScore = sim.playerScore;
+    r.botScore = sim.bestBotScore();
+    return r;
+}
+
+// Anillo de partículas saturado: cada tick entran 64 impactos (más de los que mueren) y se mide
+// el coste de un impacto y el update de la ventana entera, sin hilos y con 'jobs'
+static void benchParticles(JobSystem* jobs, int ticks) {
+    ParticleSystem particles(PARTICLE_CAPACITY, 1.0f);
+    particles.reset(1);
+    SimRng rng(7);
+    const int BURSTS_PER_TICK = 64;
+    double burstMs = 0, updateMs = 0;
+    long long window = 0;
+    for (int t = 0; t < ticks; t++) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int b = 0; b < BURSTS_PER_TICK; b++) {
+            particles.burst((float)rng.range(0, (int)WORLD_W), (float)rng.range(0, (int)WORLD_H), 80.0f);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        particles.update(1.0f / SIM_BASE_TICK_RATE, jobs);
+        auto t2 = std::chrono::steady_clock::now();
+        burstMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        updateMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+        window += particles.window();
+    }
+    printf("partículas (%d hilos): ventana media %lld de %d, impacto %.0f ns (%d partículas), update %.3f ms/tick  %.2f ns/partícula\n",
+           jobs ? jobs->threadCount() : 1, window / ticks, particles.getCapacity(),
+           burstMs * 1e6 / ((double)ticks * BURSTS_PER_TICK), PARTICLES_PER_HIT,
+           updateMs / ticks, updateMs * 1e6 / (double)window);
+}
+
+int main(int argc, char** argv) {
+    int ticks = argc > 1 ? atoi(argv[1]) : 6000;
+    unsigned int seed = argc > 2 ? (unsigned int)strtoul(argv[2], nullptr, 10) : 12345u;
+    int initial = argc > 3 ? atoi(argv[3]) : 15;
+    const char* broadphase = argc > 4 ? argv[4] : "loose";
+    int bots = argc > 5 ? atoi(argv[5]) : 1;
+    int workers = argc > 6 ? atoi(argv[6]) : JobSystem::defaultWorkers();
+    int tickRate = argc > 7 ? atoi(argv[7]) : SIM_BASE_TICK_RATE;
+    if (tickRate < 1) tickRate = SIM_BASE_TICK_RATE;
+    int screens = argc > 8 ? atoi(argv[8]) : 1;
+    if (screens < 1) screens = 1;
+
+    printf("ticks %d a %d/s, semilla %u, asteroides %d, broadphase %s, bots %d, hilos 1 y %d\n",
+           ticks, tickRate, seed, initial, broadphase, bots, workers + 1);
+
+    // La misma partida en un hilo y en varios: el checksum tiene que coincidir
+    RunResult a = run(ticks, seed, initial, broadphase, bots, 0, tickRate, screens);
+    RunResult b = run(ticks, seed, initial, broadphase, bots, workers, tickRate, screens);
+    if (screens > 1) {
+        // El coste por tick tiene que seguir a los despiertos, no al tamaño del mundo
+        printf("mundo de %dx%d pantallas: %d sectores activos, %d asteroides despiertos, %lld dormidos\n",
+               screens, screens, a.activeSectors, a.asteroids, a.dormant);
+    }
+
+    // A menos ticks por segundo cada segundo de juego cuesta menos
+    printf("1 hilo:   %.4f ms/tick  %.0f ticks/s  %.3f ms por segundo de juego  asteroides finales %d  puntos %d / %d\n",
+           a.ms / ticks, ticks * 1000.0 / a.ms, a.ms * tickRate / ticks, a.asteroids, a.playerScore, a.botScore);
+    printf("%d hilos: %.4f ms/tick  %.0f ticks/s  (x%.2f)\n",
+           workers + 1, b.ms / ticks, ticks * 1000.0 / b.ms, a.ms / b.ms);
+    printf("checksum %08x / %08x  %s\n", a.checksum, b.checksum,
+           a.checksum == b.checksum ? "determinista" : "DIVERGE");
+
+    benchParticles(nullptr, 600);
+    if (workers > 0) {
+        JobSystem jobs(workers);
+        benchParticles(&jobs, 600);
+    }
+    return a.checksum == b.checksum ? 0 : 1;
+}
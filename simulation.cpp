@@ -0,0 +1,536 @@
+#include "simulation.h"
+#include "profiler.h"
+
+#include <cmath>
+
+static const float SIM_PI = 3.14159265358979323846f;
+static const float SIM_DEG2RAD = SIM_PI / 180.0f;
+static const float SIM_RAD2DEG = 180.0f / SIM_PI;
+
+GameSim::GameSim(float w, float h, const SimConfig& config)
+    : jobs(new JobSystem(config.workerThreads)),
+      shipHandle(config.asteroidCapacity), firstBotHandle(config.asteroidCapacity + 1),
+      bulletCapacity(config.bulletCapacity > 0 ? config.bulletCapacity : 1),
+      botCapacity(config.botCapacity > 0 ? config.botCapacity : 0),
+      width(w), height(h),
+      asteroids(config.asteroidCapacity), bullets(bulletCapacity),
+      particles(config.particleCapacity,
+                (float)SIM_BASE_TICK_RATE / (float)(config.tickRate > 0 ? config.tickRate : SIM_BASE_TICK_RATE)),
+      visualRotation(0), lives(3), spawnTimer(0), playerScore(0), botCount(0),
+      shotsFired(0), asteroidsHit(0) {
+    asteroidCollisions = config.asteroidCollisions;
+    int tickRate = config.tickRate > 0 ? config.tickRate : SIM_BASE_TICK_RATE;
+    tickDt = 1.0f / (float)tickRate;
+    tickScale = (float)SIM_BASE_TICK_RATE / (float)tickRate;
+    // powf(x, 1) == x: al ritmo base la simulación da los mismos bits que antes
+    shipDrag = powf(0.94f, tickScale);
+    botDrag = powf(0.96f, tickScale);
+    CustomRectangle world(w/2, h/2, w, h);
+    broadphase = CreateBroadphase(config.broadphase, world);
+    if (!broadphase) broadphase = CreateBroadphase("loose", world);
+    broadphase->setJobSystem(jobs);
+    bulletDead = new unsigned char[bulletCapacity];
+    hitCommands = new HitCommand[jobs->threadCount() * bulletCapacity];
+    hitCounts = new int[jobs->threadCount()];
+    bulletHit = new const HitCommand*[bulletCapacity];
+    bots = new BotPlayer[botCapacity > 0 ? botCapacity : 1];
+    botShots = new BotShot[botCapacity > 0 ? botCapacity : 1];
+    botQueues = new NearestQueue[jobs->threadCount()];
+    asteroidBoxes = new CustomRectangle[asteroids.getCapacity()];
+    // Franjas más altas que el asteroide más grande (60 px): cada caja cae en una o dos
+    asteroidJoin = new SelfJoin(0, h, 64.0f);
+    sectors = nullptr;
+    if (config.sectorWidth > 0 && config.sectorHeight > 0 && (w > config.sectorWidth || h > config.sectorHeight)) {
+        sectors = new SectorGrid(w, h, config.sectorWidth, config.sectorHeight);
+    }
+    tickCount = 0;
+    viewStamps = new unsigned[asteroids.getCapacity()];
+    for (int i = 0; i < asteroids.getCapacity(); i++) viewStamps[i] = 0;
+    viewStamp = 0;
+
+    ship.position = Point(w/2, h/2);
+    ship.width = 40;
+    ship.height = 40; ship.id = 9999;
+    shipVel = Point(0, 0);
+}
+
+GameSim::~GameSim() {
+    delete broadphase;
+    delete[] bulletDead;
+    delete[] hitCommands;
+    delete[] hitCounts;
+    delete[] bulletHit;
+    delete[] bots;
+    delete[] botShots;
+    delete[] botQueues;
+    delete[] asteroidBoxes;
+    delete asteroidJoin;
+    delete sectors;
+    delete[] viewStamps;
+    delete jobs;
+}
+
+GameObject GameSim::asteroidObject(int i) const {
+    GameObject obj;
+    obj.position = Point(asteroids.x[i], asteroids.y[i]);
+    obj.width = obj.height = AsteroidExtent(asteroids.size[i]);
+    obj.type = 2;
+    obj.id = (int)asteroids.handle(i);
+    return obj;
+}
+
+void GameSim::spawnAsteroid(float x, float y, float vx, float vy, int size) {
+    int i = asteroids.spawn();
+    if (i == -1) return;
+    asteroids.x[i] = x; asteroids.y[i] = y;
+    asteroids.prevX[i] = x; asteroids.prevY[i] = y;
+    asteroids.vx[i] = vx; asteroids.vy[i] = vy;
+    asteroids.size[i] = size;
+    asteroids.type[i] = 2;
+    broadphase->insert(asteroidObject(i), asteroids.slot(i));
+}
+
+void GameSim::splitAsteroid(int index, int owner) {
+    int currentSize = asteroids.size[index];
+    float px = asteroids.x[index], py = asteroids.y[index];
+
+    // El slot no cambia aunque el último asteroide ocupe su hueco en la lista densa
+    broadphase->remove(asteroids.slot(index));
+    asteroids.kill(index);
+
+    if (owner == -1) playerScore += 100;
+    else bots[owner].score += 100;
+
+    if (currentSize > 1) {
+        for (int created = 0; created < 2; created++) {
+            float angle = (float)rng.range(0, 360) * SIM_DEG2RAD;
+            spawnAsteroid(px, py, cosf(angle) * 2.5f, sinf(angle) * 2.5f, currentSize - 1);
+        }
+    }
+}
+
+bool GameSim::fireBullet(Point from, float rotation, float speed, int type, int owner) {
+    int i = bullets.spawn();
+    if (i == -1) return false;
+    bullets.x[i] = from.x; bullets.y[i] = from.y;
+    bullets.prevX[i] = from.x; bullets.prevY[i] = from.y;
+    bullets.vx[i] = cosf(rotation * SIM_DEG2RAD) * speed;
+    bullets.vy[i] = sinf(rotation * SIM_DEG2RAD) * speed;
+    bullets.type[i] = type;
+    bullets.owner[i] = owner;
+    shotsFired++;
+    return true;
+}
+
+void GameSim::reset(unsigned int seed, int requestedBots, int initialAsteroids) {
+    rng.seed(seed);
+    playerScore = 0; lives = 3;
+    ship.position = Point(width / 3, height / 2);
+    shipPrev = ship.position;
+    shipVel = Point(0, 0); spawnTimer = 3.0f; visualRotation = 0;
+    shotsFired = 0; asteroidsHit = 0;
+
+    asteroids.clear();
+    bullets.clear();
+    // Las partículas tienen su propio generador: los efectos no cambian la partida
+    particles.reset(seed ^ 0x9E3779B9u);
+
+    broadphase->clear();
+    broadphase->insert(ship, shipHandle);
+
+    // El primer bot sale donde salía el único bot; el resto en una rejilla sobre el mundo
+    botCount = requestedBots < 0 ? 0 : (requestedBots > botCapacity ? botCapacity : requestedBots);
+    int gridCols = (int)ceilf(sqrtf((float)botCount));
+    for (int i = 0; i < botCount; i++) {
+        BotPlayer& b = bots[i];
+        b.entity = GameObject();
+        b.entity.width = 30;
+        b.entity.height = 30;
+        if (i == 0) {
+            b.entity.position = Point(width * 0.7f, height / 2);
+        } else {
+            b.entity.position = Point(width * ((i % gridCols) + 0.5f) / gridCols,
+                                      height * ((i / gridCols) + 0.5f) / gridCols);
+        }
+        b.prevPosition = b.entity.position;
+        b.velocity = Point(0, 0); b.active = true; b.rotation = 0;
+        b.fireTimer = 0; b.score = 0; b.wanderTimer = 0; b.aimError = 0;
+        // Semilla de cada bot mezclada con su índice para que las secuencias no se parezcan
+        unsigned int botSeed = seed ^ ((unsigned int)(i + 1) * 0x9E3779B9u);
+        botSeed ^= botSeed >> 16; botSeed *= 0x85EBCA6Bu; botSeed ^= botSeed >> 13;
+        b.rng.seed(botSeed);
+        broadphase->insert(b.entity, firstBotHandle + i);
+    }
+
+    // Con sectores todos empiezan dormidos y despiertan los que están cerca de la nave y los bots
+    tickCount = 0;
+    if (sectors) sectors->clear();
+    for (int i = 0; i < initialAsteroids; i++) {
+        float x = (float)rng.range(0, (int)width);
+        float y = (float)rng.range(0, (int)height);
+        float vx = (float)rng.range(-200, 200)/100.0f;
+        float vy = (float)rng.range(-200, 200)/100.0f;
+        if (sectors) sectors->store(sectors->sectorOf(x, y), x, y, vx, vy, 3, 0);
+        else spawnAsteroid(x, y, vx, vy, 3);
+    }
+    if (sectors) streamSectors();
+}
+
+void GameSim::streamSectors() {
+    PROFILE_SCOPE(PROFILE_STREAM);
+    sectors->beginFocus();
+    sectors->addFocus(ship.position.x, ship.position.y);
+    for (int i = 0; i < botCount; i++) sectors->addFocus(bots[i].entity.position.x, bots[i].entity.position.y);
+    sectors->updateActive();
+
+    // Duermen los asteroides que están en un sector inactivo (hacia atrás: kill mueve el último a 'i')
+    for (int i = asteroids.count - 1; i >= 0; i--) {
+        int s = sectors->sectorOf(asteroids.x[i], asteroids.y[i]);
+        if (sectors->isActive(s)) continue;
+        sectors->store(s, asteroids.x[i], asteroids.y[i], asteroids.vx[i], asteroids.vy[i], asteroids.size[i], tickCount);
+        broadphase->remove(asteroids.slot(i));
+        asteroids.kill(i);
+    }
+    // Despiertan los de los sectores activos mientras quepan; el resto lo intenta el siguiente tick
+    for (int n = 0; n < sectors->activeSectors(); n++) {
+        sectors->wake(sectors->activeSector(n), tickCount, tickScale, [this](float x, float y, float vx, float vy, int size) {
+            if (asteroids.full()) return false;
+            spawnAsteroid(x, y, vx, vy, size);
+            return true;
+        });
+    }
+    PROFILE_SET(PROFILE_DORMANT, sectors->dormantCount());
+}
+
+// Parte el intervalo [lo, lo + size) del mundo envuelto [0, span) en uno o dos tramos
+static int splitWrapped(float lo, float size, float span, float out[2][2]) {
+    if (size >= span) {
+        out[0][0] = 0; out[0][1] = span;
+        return 1;
+    }
+    lo -= floorf(lo / span) * span;
+    out[0][0] = lo;
+    out[0][1] = lo + size < span ? lo + size : span;
+    if (lo + size <= span) return 1;
+    out[1][0] = 0; out[1][1] = lo + size - span;
+    return 2;
+}
+
+int GameSim::visibleAsteroids(const CustomRectangle& view, int* out) {
+    if (++viewStamp == 0) {
+        for (int i = 0; i < asteroids.getCapacity(); i++) viewStamps[i] = 0;
+        viewStamp = 1;
+    }
+    float xs[2][2], ys[2][2];
+    int nx = splitWrapped(view.x - view.width/2, view.width, width, xs);
+    int ny = splitWrapped(view.y - view.height/2, view.height, height, ys);
+    int count = 0;
+    for (int a = 0; a < nx; a++) {
+        for (int b = 0; b < ny; b++) {
+            CustomRectangle piece((xs[a][0] + xs[a][1]) / 2, (ys[b][0] + ys[b][1]) / 2,
+                                  xs[a][1] - xs[a][0], ys[b][1] - ys[b][0]);
+            // La nave y los bots tienen handles detrás de los slots de asteroides: indexOfSlot da -1
+            for (int h : broadphase->queryHandles(piece)) {
+                int i = asteroids.indexOfSlot(h);
+                if (i == -1 || viewStamps[h] == viewStamp) continue;
+                viewStamps[h] = viewStamp;
+                out[count++] = i;
+            }
+        }
+    }
+    return count;
+}
+
+void GameSim::updateBot(int index, float dt, NearestQueue& queue) {
+    BotPlayer& b = bots[index];
+    BotShot& shot = botShots[index];
+    shot.requested = false;
+    if (!b.active) return;
+
+    // Asteroide más cercano a través del broadphase: coste logarítmico en vez de recorrerlos todos
+    float closestDist = 2000.0f;
+    int target = -1;
+    float targetDist2;
+    if (broadphase->nearest(b.entity.position, 1, closestDist, 2, queue, &target, &targetDist2) == 1) {
+        closestDist = sqrtf(targetDist2);
+    }
+
+    b.wanderTimer -= dt;
+
+    if (target != -1 && b.wanderTimer <= 0) {
+        if (b.rng.range(0, 100) < 5) b.aimError = (float)b.rng.range(-15, 15); // Cambia el error de vez en cuando
+
+        const Point& tp = broadphase->get(target).position;
+        float angleToTarget = atan2f(tp.y - b.entity.position.y, tp.x - b.entity.position.x) * SIM_RAD2DEG;
+        float diff = (angleToTarget + b.aimError) - b.rotation;
+
+        while (diff > 180) diff -= 360;
+        while (diff < -180) diff += 360;
+        b.rotation += diff * 0.05f * tickScale;
+
+        b.velocity.x += cosf(b.rotation * SIM_DEG2RAD) * 0.15f * tickScale;
+        b.velocity.y += sinf(b.rotation * SIM_DEG2RAD) * 0.15f * tickScale;
+
+        b.fireTimer += dt;
+        if (b.fireTimer > 0.6f && closestDist < 600) {
+            if (b.rng.range(0, 10) > 2) {
+                // La bala se crea al fusionar; si no cabe, el temporizador vuelve a este valor
+                shot.requested = true;
+                shot.from = b.entity.position;
+                shot.rotation = b.rotation;
+                shot.prevFireTimer = b.fireTimer;
+                b.fireTimer = 0;
+            } else {
+                b.fireTimer = 0.3f;
+            }
+        }
+    } else {
+        if (b.wanderTimer <= -1.5f) {
+            b.wanderTimer = (float)b.rng.range(1, 3);
+            b.velocity.x += (float)b.rng.range(-5, 5);
+            b.velocity.y += (float)b.rng.range(-5, 5);
+        }
+        b.rotation += 2.0f * tickScale;
+    }
+
+    b.prevPosition = b.entity.position;
+    b.entity.position.x += b.velocity.x * tickScale; b.entity.position.y += b.velocity.y * tickScale;
+    b.velocity.x *= botDrag; b.velocity.y *= botDrag;
+
+    if (b.entity.position.x > width) b.entity.position.x = 0; else if (b.entity.position.x < 0) b.entity.position.x = width;
+    if (b.entity.position.y > height) b.entity.position.y = 0; else if (b.entity.position.y < 0) b.entity.position.y = height;
+}
+
+void GameSim::updateBots(float dt) {
+    if (botCount == 0) return;
+    PROFILE_SCOPE(PROFILE_BOTS);
+    // Fase en paralelo: cada bot solo escribe en sí mismo y en su BotShot; el broadphase se lee
+    broadphase->maintain();
+    jobs->parallelFor(botCount, 16, [this, dt](int begin, int end, int thread) {
+        for (int i = begin; i < end; i++) updateBot(i, dt, botQueues[thread]);
+    });
+    // Fusión en orden de bot: las balas salen igual con cualquier número de hilos
+    for (int i = 0; i < botCount; i++) {
+        const BotShot& shot = botShots[i];
+        if (!shot.requested) continue;
+        if (!fireBullet(shot.from, shot.rotation, 11.0f, 4, i)) bots[i].fireTimer = shot.prevFireTimer;
+    }
+}
+
+void GameSim::resolveBullets() {
+    // Mover las balas. Las que salen del mundo se marcan en bulletDead pero aún se prueba su último
+    // tramo: pueden tocar algo antes de salir.
+    bullets.savePositions();
+    IntegrateCull(bullets, width, height, tickScale, bulletDead);
+    // En un mundo por sectores las balas también mueren al entrar en uno dormido
+    if (sectors) {
+        for (int i = 0; i < bullets.count; i++) {
+            if (!sectors->isActive(sectors->sectorOf(bullets.x[i], bullets.y[i]))) bulletDead[i] = 1;
+        }
+    }
+
+    // Fase en paralelo: cada bala busca el primer asteroide que cruza en su trayecto del tick, así no
+    // atraviesa asteroides pequeños aunque el tick sea largo. Los asteroides se prueban en su posición
+    // final del tick. Solo lee el broadphase; lo que encuentra va al buffer de comandos de su hilo.
+    int bulletCount = bullets.count;
+    {
+        PROFILE_SCOPE(PROFILE_BULLETS);
+        for (int t = 0; t < jobs->threadCount(); t++) hitCounts[t] = 0;
+        jobs->parallelFor(bulletCount, 8, [this](int begin, int end, int thread) {
+            HitCommand* out = hitCommands + thread * bulletCapacity;
+            for (int i = begin; i < end; i++) {
+                float toi;
+                int h = broadphase->sweepFirst(Point(bullets.prevX[i], bullets.prevY[i]), Point(bullets.x[i], bullets.y[i]),
+                                               BULLET_HALF_EXTENT, BULLET_HALF_EXTENT, 2, toi);
+                if (h == -1) continue;
+                const GameObject& obj = broadphase->get(h);
+                HitCommand& cmd = out[hitCounts[thread]++];
+                cmd.bullet = i;
+                cmd.asteroid = (EntityHandle)obj.id;
+                cmd.position = obj.position;
+            }
+        });
+    }
+
+    // Orden determinista: cada bala genera como mucho un comando, así que se colocan por índice
+    for (int i = 0; i < bulletCount; i++) bulletHit[i] = nullptr;
+    for (int t = 0; t < jobs->threadCount(); t++) {
+        const HitCommand* cmds = hitCommands + t * bulletCapacity;
+        for (int c = 0; c < hitCounts[t]; c++) bulletHit[cmds[c].bullet] = &cmds[c];
+    }
+
+    {
+        PROFILE_SCOPE(PROFILE_SPLIT);
+        for (int i = 0; i < bulletCount; i++) {
+            const HitCommand* cmd = bulletHit[i];
+            if (!cmd) continue;
+            // Comprobación generacional: si otra bala ya lo rompió este frame, esta sigue volando
+            int k = asteroids.find(cmd->asteroid);
+            if (k == -1) continue;
+            bulletDead[i] = 1;
+            // El fogonazo usa el tamaño de los fragmentos (o 1 si el asteroide desaparece)
+            int hitSize = asteroids.size[k];
+            splitAsteroid(k, bullets.owner[i]);
+            asteroidsHit++;
+            particles.burst(cmd->position.x, cmd->position.y, (float)(hitSize > 1 ? hitSize - 1 : 1) * 80.0f);
+        }
+    }
+    for (int i = bulletCount - 1; i >= 0; i--) if (bulletDead[i]) bullets.kill(i);
+}
+
+void GameSim::collideAsteroids() {
+    PROFILE_SCOPE(PROFILE_COLLIDE);
+    int n = asteroids.count;
+    for (int i = 0; i < n; i++) {
+        float e = AsteroidExtent(asteroids.size[i]);
+        asteroidBoxes[i] = CustomRectangle(asteroids.x[i], asteroids.y[i], e, e);
+    }
+    // Cada par una sola vez y en el mismo orden con cualquier número de hilos
+    asteroidJoin->run(asteroidBoxes, n, asteroidPairs, jobs);
+    PROFILE_SET(PROFILE_PAIRS, asteroidPairs.size());
+
+    // Rebote como círculos de diámetro igual a la caja, masa proporcional al área.
+    // Se aplica en orden de par: un asteroide con varios choques los resuelve uno tras otro.
+    for (int p = 0; p < asteroidPairs.size(); p++) {
+        int a = asteroidPairs[p].a, b = asteroidPairs[p].b;
+        float dx = asteroids.x[b] - asteroids.x[a];
+        float dy = asteroids.y[b] - asteroids.y[a];
+        float ra = asteroidBoxes[a].width / 2, rb = asteroidBoxes[b].width / 2;
+        float reach = ra + rb;
+        float dist2 = dx*dx + dy*dy;
+        // Los fragmentos recién partidos salen del mismo punto: sin dirección no hay choque
+        if (dist2 >= reach*reach || dist2 == 0) continue;
+        float dist = sqrtf(dist2);
+        float nx = dx / dist, ny = dy / dist;
+        float invA = 1.0f / (ra*ra), invB = 1.0f / (rb*rb);
+
+        // Impulso elástico solo si se acercan; si ya se separan basta con la corrección de posición
+        float approach = (asteroids.vx[b] - asteroids.vx[a]) * nx + (asteroids.vy[b] - asteroids.vy[a]) * ny;
+        if (approach < 0) {
+            float j = -2.0f * approach / (invA + invB);
+            asteroids.vx[a] -= j * invA * nx; asteroids.vy[a] -= j * invA * ny;
+            asteroids.vx[b] += j * invB * nx; asteroids.vy[b] += j * invB * ny;
+        }
+        // Separa la mitad del solape por tick, más al ligero: los montones se deshacen sin saltos
+        float push = (reach - dist) * 0.5f / (invA + invB);
+        asteroids.x[a] -= push * invA * nx; asteroids.y[a] -= push * invA * ny;
+        asteroids.x[b] += push * invB * nx; asteroids.y[b] += push * invB * ny;
+    }
+    // La corrección puede sacarlos del mundo: se envuelven como en la integración
+    for (int i = 0; i < n; i++) {
+        if (asteroids.x[i] > width) asteroids.x[i] = 0; else if (asteroids.x[i] < 0) asteroids.x[i] = width;
+        if (asteroids.y[i] > height) asteroids.y[i] = 0; else if (asteroids.y[i] < 0) asteroids.y[i] = height;
+    }
+}
+
+void GameSim::step(const SimInput& input) {
+    PROFILE_SCOPE(PROFILE_STEP);
+    float dt = tickDt;
+    shotsFired = 0;
+    asteroidsHit = 0;
+    if (spawnTimer > 0) spawnTimer -= dt;
+
+    float thrust = 0.6f * tickScale;
+    if (input.has(SIM_UP)) shipVel.y -= thrust;
+    if (input.has(SIM_DOWN)) shipVel.y += thrust;
+    if (input.has(SIM_LEFT)) shipVel.x -= thrust;
+    if (input.has(SIM_RIGHT)) shipVel.x += thrust;
+
+    shipVel.x *= shipDrag; shipVel.y *= shipDrag;
+    if (sqrtf(shipVel.x*shipVel.x + shipVel.y*shipVel.y) > 0.1f) visualRotation = atan2f(shipVel.y, shipVel.x) * SIM_RAD2DEG;
+    shipPrev = ship.position;
+    ship.position.x += shipVel.x * tickScale; ship.position.y += shipVel.y * tickScale;
+
+    if (ship.position.x > width) ship.position.x = 0; else if (ship.position.x < 0) ship.position.x = width;
+    if (ship.position.y > height) ship.position.y = 0; else if (ship.position.y < 0) ship.position.y = height;
+
+    if (input.has(SIM_FIRE)) fireBullet(ship.position, visualRotation, 12.0f, 3, -1); // Tipo jugador
+
+    // Sectores que entran y salen alrededor de la nave y los bots antes de que nadie consulte
+    tickCount++;
+    if (sectors) streamSectors();
+
+    // Los bots consultan el broadphase antes de mover nada en él: así el quadtree no se reconstruye dos veces
+    updateBots(dt);
+
+    broadphase->update(shipHandle, ship.getBounds());
+    for (int i = 0; i < botCount; i++) broadphase->update(firstBotHandle + i, bots[i].entity.getBounds());
+
+    {
+        PROFILE_SCOPE(PROFILE_INTEGRATE);
+        asteroids.savePositions();
+        jobs->parallelFor(asteroids.count, 512, [this](int begin, int end, int) {
+            IntegrateWrap(asteroids, width, height, tickScale, begin, end);
+        });
+    }
+    if (asteroidCollisions) collideAsteroids();
+    {
+        PROFILE_SCOPE(PROFILE_BROADPHASE);
+        for (int i = 0; i < asteroids.count; i++) {
+            float e = AsteroidExtent(asteroids.size[i]);
+            broadphase->update(asteroids.slot(i), CustomRectangle(asteroids.x[i], asteroids.y[i], e, e));
+        }
+        broadphase->maintain();
+    }
+
+    if (spawnTimer <= 0) {
+        bool shipHit = false;
+        for (int h : broadphase->queryHandles(ship.getBounds())) {
+            if (broadphase->get(h).type == 2) { shipHit = true; break; }
+        }
+        if (shipHit) {
+            lives--; ship.position = Point(width/3, height/2); shipPrev = ship.position; shipVel = Point(0, 0); spawnTimer = 3.0f;
+            broadphase->update(shipHandle, ship.getBounds());
+            // Las consultas de las balas son de solo lectura: el broadphase tiene que estar al día
+            broadphase->maintain();
+        }
+    }
+
+    {
+        // Antes de los impactos: las partículas nuevas se dibujan primero donde nacen
+        PROFILE_SCOPE(PROFILE_PARTICLES);
+        particles.update(dt, jobs);
+    }
+    resolveBullets();
+
+    PROFILE_SET(PROFILE_PARTICLE_WINDOW, particles.window());
+    PROFILE_SET(PROFILE_NODES, broadphase->nodeTotal());
+    PROFILE_SET(PROFILE_ALLOCS, broadphase->allocationCount());
+}
+
+// FNV-1a sobre los bits exactos de cada valor
+static inline void hashBytes(unsigned int& h, const void* data, int n) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (int i = 0; i < n; i++) { h ^= p[i]; h *= 16777619u; }
+}
+
+unsigned int GameSim::checksum() const {
+    unsigned int h = 2166136261u;
+    hashBytes(h, &asteroids.count, sizeof(int));
+    hashBytes(h, asteroids.x, asteroids.count * (int)sizeof(float));
+    hashBytes(h, asteroids.y, asteroids.count * (int)sizeof(float));
+    hashBytes(h, asteroids.size, asteroids.count * (int)sizeof(int));
+    hashBytes(h, &bullets.count, sizeof(int));
+    hashBytes(h, bullets.x, bullets.count * (int)sizeof(float));
+    hashBytes(h, bullets.y, bullets.count * (int)sizeof(float));
+    hashBytes(h, &ship.position, sizeof(Point));
+    hashBytes(h, &playerScore, sizeof(int));
+    hashBytes(h, &botCount, sizeof(int));
+    for (int i = 0; i < botCount; i++) {
+        hashBytes(h, &bots[i].entity.position, sizeof(Point));
+        hashBytes(h, &bots[i].score, sizeof(int));
+    }
+    hashBytes(h, &lives, sizeof(int));
+    // Los dormidos solo por número: recorrer millones en cada frame de una grabación no compensa
+    if (sectors) {
+        long long dormant = sectors->dormantCount();
+        hashBytes(h, &dormant, sizeof(dormant));
+    }
+    return h;
+}
+
+int GameSim::bestBotScore() const {
+    int best = 0;
+    for (int i = 0; i < botCount; i++) if (bots[i].score > best) best = bots[i].score;
+    return best;
+}
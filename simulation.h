@@ -0,0 +1,208 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "quadtree.h"
+#include "broadphase.h"
+#include "entities.h"
+#include "rng.h"
+#include "jobs.h"
+#include "selfjoin.h"
+#include "particles.h"
+#include "sectors.h"
+
+// Simulación del juego sin raylib: entrada, audio y dibujo quedan en asteroid.cpp.
+// Con la misma semilla y la misma secuencia de entradas produce exactamente el mismo estado.
+
+const int MAX_ASTEROIDS = 2000;
+const int MAX_BULLETS = 60;
+// Un bot dispara como mucho cada 0.6 s y una bala cruza la pantalla en unos 2 s
+const int BULLETS_PER_BOT = 4;
+// Las balas chocan como una caja de 10x10 que recorre su trayecto del tick
+const float BULLET_HALF_EXTENT = 5.0f;
+// Las constantes de movimiento (velocidades, rozamiento, giro) están pensadas por tick a este ritmo;
+// a otro ritmo se escalan para que la física en tiempo real sea la misma
+const int SIM_BASE_TICK_RATE = 60;
+
+enum SimButton { SIM_UP = 1, SIM_DOWN = 2, SIM_LEFT = 4, SIM_RIGHT = 8, SIM_FIRE = 16 };
+
+struct SimInput {
+    unsigned int buttons; // combinación de SimButton (SIM_FIRE solo en el frame en que se pulsa)
+    SimInput(unsigned int b = 0) : buttons(b) {}
+    bool has(SimButton b) const { return (buttons & b) != 0; }
+};
+
+struct BotPlayer {
+    GameObject entity;
+    Point prevPosition; // al empezar el tick, para interpolar
+    Point velocity;
+    float rotation;
+    bool active;
+    float fireTimer;
+    int score;
+    float wanderTimer;
+    float aimError;
+    SimRng rng; // propio de cada bot: el resultado no depende del orden en que se actualicen
+};
+
+// Disparo pedido por un bot durante la fase en paralelo; se crea la bala después, en orden de bot
+struct BotShot {
+    bool requested;
+    Point from;
+    float rotation;
+    float prevFireTimer; // se restaura si no queda sitio para la bala
+};
+
+struct SimConfig {
+    const char* broadphase; // como en CreateBroadphase ("loose", "quadtree" o "grid")
+    int asteroidCapacity;
+    int bulletCapacity;
+    int botCapacity;
+    int workerThreads;      // hilos auxiliares; el resultado no depende de cuántos haya
+    int tickRate;           // ticks por segundo de step()
+    bool asteroidCollisions; // los asteroides rebotan entre sí
+    int particleCapacity;   // anillo de partículas de los impactos
+    // Sectores de un mundo más grande que la pantalla (ver SectorGrid); 0 = todo el mundo activo.
+    // Con sectores, asteroidCapacity limita los asteroides despiertos, no los del mundo.
+    float sectorWidth, sectorHeight;
+
+    SimConfig() : broadphase("loose"), asteroidCapacity(MAX_ASTEROIDS), bulletCapacity(MAX_BULLETS),
+                  botCapacity(1), workerThreads(0), tickRate(SIM_BASE_TICK_RATE), asteroidCollisions(true),
+                  particleCapacity(PARTICLE_CAPACITY), sectorWidth(0), sectorHeight(0) {}
+};
+
+// Reloj de paso fijo: acumula el tiempo real de cada frame y dice cuántos ticks simular.
+// Si un frame se alarga (carga, ventana arrastrada) se simulan como mucho maxSteps ticks y el
+// resto se descarta: la partida va más lenta un momento en vez de encadenar frames cada vez peores.
+class FixedTimestep {
+private:
+    double tickDt;
+    double accumulator;
+    int maxSteps;
+    long long droppedTicks;
+public:
+    FixedTimestep(int tickRate, int maxStepsPerFrame = 5)
+        : tickDt(1.0 / (tickRate > 0 ? tickRate : SIM_BASE_TICK_RATE)), accumulator(0),
+          maxSteps(maxStepsPerFrame > 0 ? maxStepsPerFrame : 1), droppedTicks(0) {}
+
+    // Suma 'frameTime' segundos y devuelve los ticks que tocan ahora
+    int advance(double frameTime) {
+        if (frameTime > 0) accumulator += frameTime;
+        int steps = 0;
+        while (accumulator >= tickDt && steps < maxSteps) { accumulator -= tickDt; steps++; }
+        if (accumulator >= tickDt) {
+            long long behind = (long long)(accumulator / tickDt);
+            droppedTicks += behind;
+            accumulator -= behind * tickDt;
+        }
+        return steps;
+    }
+    // Fracción del siguiente tick ya transcurrida, en [0, 1): peso del estado actual al interpolar
+    float alpha() const { return (float)(accumulator / tickDt); }
+    void reset() { accumulator = 0; }
+    long long dropped() const { return droppedTicks; }
+};
+
+// Impacto detectado por una bala durante la fase en paralelo; se aplica después en orden de bala
+struct HitCommand {
+    int bullet;
+    EntityHandle asteroid;
+    Point position;
+};
+
+class GameSim {
+private:
+    SimRng rng;
+    JobSystem* jobs;
+    // Claves del broadphase: los asteroides usan su slot estable, la nave y los bots van detrás
+    int shipHandle;
+    int firstBotHandle;
+    int bulletCapacity;
+    int botCapacity;
+    unsigned char* bulletDead;
+    // Un buffer de comandos por hilo (bulletCapacity cada uno) y el comando de cada bala tras ordenarlos
+    HitCommand* hitCommands;
+    int* hitCounts;
+    const HitCommand** bulletHit;
+    BotShot* botShots;
+    NearestQueue* botQueues; // una por hilo
+    // Paso fijo: tickScale = SIM_BASE_TICK_RATE / tickRate (exactamente 1 al ritmo base)
+    float tickDt;
+    float tickScale;
+    float shipDrag, botDrag; // rozamiento por tick
+    // Choques entre asteroides: cajas del tick, autojoin y pares reutilizados entre ticks
+    bool asteroidCollisions;
+    CustomRectangle* asteroidBoxes;
+    SelfJoin* asteroidJoin;
+    PairBuffer asteroidPairs;
+    // Mundo por sectores (nullptr si todo el mundo está activo) y ticks desde reset()
+    SectorGrid* sectors;
+    int tickCount;
+    // Marcas de visibleAsteroids por slot, para no devolver dos veces lo que cruza un borde
+    unsigned* viewStamps;
+    unsigned viewStamp;
+
+    GameObject asteroidObject(int i) const;
+    void spawnAsteroid(float x, float y, float vx, float vy, int size);
+    // 'owner' es el bot que disparó la bala, o -1 si fue el jugador
+    void splitAsteroid(int index, int owner);
+    bool fireBullet(Point from, float rotation, float speed, int type, int owner);
+    void updateBot(int index, float dt, NearestQueue& queue);
+    void updateBots(float dt);
+    void resolveBullets();
+    void collideAsteroids();
+    void streamSectors();
+
+    GameSim(const GameSim&) = delete;
+    GameSim& operator=(const GameSim&) = delete;
+public:
+    float width, height;
+    EntityStore asteroids;
+    EntityStore bullets;
+    ParticleSystem particles;
+    Broadphase* broadphase;
+
+    GameObject ship;
+    Point shipPrev; // posición al empezar el tick
+    Point shipVel;
+    float visualRotation;
+    int lives;
+    float spawnTimer;
+    int playerScore;
+    // Bots vivos en [0, botCount); el 0 es el compañero del modo duo
+    BotPlayer* bots;
+    int botCount;
+
+    // Eventos del último step(), para que el juego reproduzca los sonidos
+    int shotsFired;
+    int asteroidsHit;
+
+    GameSim(float w, float h, const SimConfig& config);
+    ~GameSim();
+
+    // 'requestedBots' se limita a config.botCapacity
+    void reset(unsigned int seed, int requestedBots, int initialAsteroids = 15);
+    // Avanza un tick de 1 / config.tickRate segundos
+    void step(const SimInput& input);
+    float tickSeconds() const { return tickDt; }
+    // Huella del estado (posiciones, puntuaciones, vidas) para detectar divergencias
+    unsigned int checksum() const;
+    // Mejor puntuación entre los bots (0 si no hay)
+    int bestBotScore() const;
+    // Hilos de la simulación; el juego los reutiliza para trabajo de carga
+    JobSystem* jobSystem() const { return jobs; }
+    // Índices densos de los asteroides despiertos que tocan 'view' (que puede salirse del mundo:
+    // se parte por los bordes). 'out' necesita sitio para asteroids.getCapacity(). Para dibujar:
+    // el coste sigue a lo que se ve, no al tamaño del mundo. Lo que asoma al otro lado de un borde
+    // del mundo no se encuentra: el margen de 'view' sobre la pantalla tiene que cubrir el radio.
+    int visibleAsteroids(const CustomRectangle& view, int* out);
+    // Asteroides dormidos en sectores lejanos (0 sin sectores)
+    long long dormantAsteroids() const { return sectors ? sectors->dormantCount() : 0; }
+    int activeSectors() const { return sectors ? sectors->activeSectors() : 0; }
+};
+
+// Los asteroides iniciales (tamaño 3) chocan con la misma caja de 60 px que los de tamaño 2
+inline float AsteroidExtent(int size) {
+    return size >= 2 ? 60.0f : (float)size * 30.0f;
+}
+
+#endif
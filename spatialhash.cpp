@@ -0,0 +1,338 @@
+#include "spatialhash.h"
+
+#include <cmath>
+
+SpatialHash::SpatialHash(float x, float y, float w, float h, float cellSize)
+    : originX(x), originY(y), worldW(w), worldH(h),
+      items(nullptr), alive(nullptr), stamps(nullptr), handleCapacity(0), maxHandle(-1),
+      stamp(0), dirty(false),
+      cellItems(nullptr), entryCount(0), entryCapacity(0),
+      pending(nullptr), pendingCount(0), pendingCapacity(0),
+      scratch(nullptr), scratchCount(0), scratchCapacity(0), allocations(0) {
+    // Las celdas dividen el mundo exactamente para que envolver un índice sea un módulo
+    cols = (int)(w / cellSize + 0.5f); if (cols < 1) cols = 1;
+    rows = (int)(h / cellSize + 0.5f); if (rows < 1) rows = 1;
+    cellW = w / cols;
+    cellH = h / rows;
+    cellStart = new int[cols * rows + 1];
+    cellCursor = new int[cols * rows];
+    for (int c = 0; c <= cols * rows; c++) cellStart[c] = 0;
+}
+
+SpatialHash::~SpatialHash() {
+    delete[] items;
+    delete[] alive;
+    delete[] stamps;
+    delete[] cellStart;
+    delete[] cellCursor;
+    delete[] cellItems;
+    delete[] pending;
+    delete[] scratch;
+}
+
+template <typename T>
+void SpatialHash::reserveArray(T*& data, int used, int newCap) {
+    T* newData = new T[newCap];
+    for (int i = 0; i < used; i++) newData[i] = data[i];
+    delete[] data;
+    data = newData;
+    allocations++;
+}
+
+void SpatialHash::reserveHandles(int handle) {
+    if (handle < handleCapacity) return;
+    int newCap = handleCapacity > 0 ? handleCapacity * 2 : 64;
+    while (newCap <= handle) newCap *= 2;
+    reserveArray(items, handleCapacity, newCap);
+    reserveArray(alive, handleCapacity, newCap);
+    reserveArray(stamps, handleCapacity, newCap);
+    for (int h = handleCapacity; h < newCap; h++) {
+        alive[h] = 0;
+        stamps[h] = 0;
+    }
+    handleCapacity = newCap;
+}
+
+void SpatialHash::cellSpan(float lo, float size, float cell, int cells, int& first, int& count) const {
+    int a = (int)floorf(lo / cell);
+    int b = (int)floorf((lo + size) / cell);
+    count = b - a + 1;
+    if (count > cells) count = cells;
+    first = ((a % cells) + cells) % cells;
+}
+
+bool SpatialHash::wrappedIntersects(const CustomRectangle& a, const CustomRectangle& b) const {
+    // Distancia mínima entre centros teniendo en cuenta que el mundo se envuelve
+    float dx = fmodf(fabsf(a.x - b.x), worldW);
+    float dy = fmodf(fabsf(a.y - b.y), worldH);
+    if (dx > worldW / 2) dx = worldW - dx;
+    if (dy > worldH / 2) dy = worldH - dy;
+    return dx <= (a.width + b.width) / 2 && dy <= (a.height + b.height) / 2;
+}
+
+void SpatialHash::rebuild() {
+    int cellCount = cols * rows;
+    for (int c = 0; c <= cellCount; c++) cellStart[c] = 0;
+
+    // 1ª pasada: contar cuántas entradas caen en cada celda
+    int total = 0;
+    for (int h = 0; h <= maxHandle; h++) {
+        if (!alive[h]) continue;
+        CustomRectangle b = items[h].getBounds();
+        int cx, nx, cy, ny;
+        cellSpan(b.x - b.width/2 - originX, b.width, cellW, cols, cx, nx);
+        cellSpan(b.y - b.height/2 - originY, b.height, cellH, rows, cy, ny);
+        for (int j = 0; j < ny; j++) {
+            int row = (cy + j) % rows;
+            for (int i = 0; i < nx; i++) cellStart[row * cols + (cx + i) % cols + 1]++;
+        }
+        total += nx * ny;
+    }
+
+    // Suma prefija: cellStart[c] pasa a ser el inicio de la celda c
+    for (int c = 0; c < cellCount; c++) cellStart[c + 1] += cellStart[c];
+    if (total > entryCapacity) {
+        int newCap = entryCapacity > 0 ? entryCapacity : 64;
+        while (newCap < total) newCap *= 2;
+        reserveArray(cellItems, 0, newCap);
+        entryCapacity = newCap;
+    }
+
+    // 2ª pasada: repartir los handles en su celda
+    for (int c = 0; c < cellCount; c++) cellCursor[c] = cellStart[c];
+    for (int h = 0; h <= maxHandle; h++) {
+        if (!alive[h]) continue;
+        CustomRectangle b = items[h].getBounds();
+        int cx, nx, cy, ny;
+        cellSpan(b.x - b.width/2 - originX, b.width, cellW, cols, cx, nx);
+        cellSpan(b.y - b.height/2 - originY, b.height, cellH, rows, cy, ny);
+        for (int j = 0; j < ny; j++) {
+            int row = (cy + j) % rows;
+            for (int i = 0; i < nx; i++) cellItems[cellCursor[row * cols + (cx + i) % cols]++] = h;
+        }
+    }
+    entryCount = total;
+    pendingCount = 0;
+    dirty = false;
+}
+
+void SpatialHash::insert(const GameObject& object, int handle) {
+    if (handle < 0) return;
+    reserveHandles(handle);
+    if (handle > maxHandle) maxHandle = handle;
+    items[handle] = object;
+    alive[handle] = 1;
+    if (dirty) return;
+    if (pendingCount == pendingCapacity) {
+        int newCap = pendingCapacity > 0 ? pendingCapacity * 2 : 64;
+        reserveArray(pending, pendingCount, newCap);
+        pendingCapacity = newCap;
+    }
+    pending[pendingCount++] = handle;
+}
+
+void SpatialHash::update(int handle, const CustomRectangle& newBounds) {
+    if (handle < 0 || handle >= handleCapacity || !alive[handle]) return;
+    items[handle].position = Point(newBounds.x, newBounds.y);
+    items[handle].width = newBounds.width;
+    items[handle].height = newBounds.height;
+    dirty = true;
+}
+
+void SpatialHash::remove(int handle) {
+    if (handle >= 0 && handle < handleCapacity) alive[handle] = 0;
+}
+
+void SpatialHash::clear() {
+    for (int h = 0; h <= maxHandle; h++) alive[h] = 0;
+    maxHandle = -1;
+    entryCount = 0;
+    pendingCount = 0;
+    for (int c = 0; c <= cols * rows; c++) cellStart[c] = 0;
+    dirty = false;
+}
+
+void SpatialHash::maintain() {
+    if (dirty || pendingCount > 0) rebuild();
+}
+
+void SpatialHash::consider(int handle, const CustomRectangle& range) {
+    if (!alive[handle] || stamps[handle] == stamp) return;
+    stamps[handle] = stamp;
+    if (!wrappedIntersects(range, items[handle].getBounds())) return;
+    if (scratchCount == scratchCapacity) {
+        int newCap = scratchCapacity > 0 ? scratchCapacity * 2 : 64;
+        reserveArray(scratch, scratchCount, newCap);
+        scratchCapacity = newCap;
+    }
+    scratch[scratchCount++] = handle;
+}
+
+HandleSpan SpatialHash::queryHandles(const CustomRectangle& range) {
+    if (dirty) rebuild();
+    if (++stamp == 0) {
+        for (int h = 0; h < handleCapacity; h++) stamps[h] = 0;
+        stamp = 1;
+    }
+    scratchCount = 0;
+
+    int cx, nx, cy, ny;
+    int tested = pendingCount;
+    cellSpan(range.x - range.width/2 - originX, range.width, cellW, cols, cx, nx);
+    cellSpan(range.y - range.height/2 - originY, range.height, cellH, rows, cy, ny);
+    for (int j = 0; j < ny; j++) {
+        int row = (cy + j) % rows;
+        for (int i = 0; i < nx; i++) {
+            int c = row * cols + (cx + i) % cols;
+            tested += cellStart[c + 1] - cellStart[c];
+            for (int e = cellStart[c]; e < cellStart[c + 1]; e++) consider(cellItems[e], range);
+        }
+    }
+    for (int p = 0; p < pendingCount; p++) consider(pending[p], range);
+    PROFILE_COUNT(PROFILE_QUERIES, 1);
+    PROFILE_COUNT(PROFILE_TESTED, tested);
+
+    HandleSpan span = { scratch, scratchCount };
+    return span;
+}
+
+int SpatialHash::findFirst(const CustomRectangle& range, int type) const {
+    // Mismo recorrido que queryHandles; sin marcas, porque solo importa el primero
+    int found = -1;
+    int tested = 0;
+    int cx, nx, cy, ny;
+    cellSpan(range.x - range.width/2 - originX, range.width, cellW, cols, cx, nx);
+    cellSpan(range.y - range.height/2 - originY, range.height, cellH, rows, cy, ny);
+    for (int j = 0; j < ny && found == -1; j++) {
+        int row = (cy + j) % rows;
+        for (int i = 0; i < nx && found == -1; i++) {
+            int c = row * cols + (cx + i) % cols;
+            for (int e = cellStart[c]; e < cellStart[c + 1]; e++) {
+                int h = cellItems[e];
+                tested++;
+                if (alive[h] && (type == -1 || items[h].type == type) && wrappedIntersects(range, items[h].getBounds())) { found = h; break; }
+            }
+        }
+    }
+    for (int p = 0; p < pendingCount && found == -1; p++) {
+        int h = pending[p];
+        tested++;
+        if (alive[h] && (type == -1 || items[h].type == type) && wrappedIntersects(range, items[h].getBounds())) found = h;
+    }
+    PROFILE_COUNT(PROFILE_QUERIES, 1);
+    PROFILE_COUNT(PROFILE_TESTED, tested);
+    return found;
+}
+
+void SpatialHash::sweepTest(int handle, const Point& from, const Point& delta, float hx, float hy, int type,
+                            int& best, float& bestToi) const {
+    if (!alive[handle]) return;
+    const GameObject& obj = items[handle];
+    if (type != -1 && obj.type != type) return;
+    // Copia del objeto más cercana a 'from' en el mundo envuelto
+    CustomRectangle b = obj.getBounds();
+    float dx = b.x - from.x, dy = b.y - from.y;
+    if (dx > worldW / 2) b.x -= worldW; else if (dx < -worldW / 2) b.x += worldW;
+    if (dy > worldH / 2) b.y -= worldH; else if (dy < -worldH / 2) b.y += worldH;
+    float t;
+    if (!SweptBoxToi(from, delta, hx, hy, b, t)) return;
+    // A igual tiempo, el handle menor: no depende del orden de las celdas
+    if (t < bestToi || (t == bestToi && handle < best)) {
+        best = handle;
+        bestToi = t;
+    }
+}
+
+int SpatialHash::sweepFirst(const Point& from, const Point& to, float hx, float hy, int type, float& toi) const {
+    Point delta(to.x - from.x, to.y - from.y);
+    float minX = (from.x < to.x ? from.x : to.x) - hx, maxX = (from.x < to.x ? to.x : from.x) + hx;
+    float minY = (from.y < to.y ? from.y : to.y) - hy, maxY = (from.y < to.y ? to.y : from.y) + hy;
+    int best = -1;
+    float bestToi = 2.0f;
+    int tested = 0;
+    int cx, nx, cy, ny;
+    cellSpan(minX - originX, maxX - minX, cellW, cols, cx, nx);
+    cellSpan(minY - originY, maxY - minY, cellH, rows, cy, ny);
+    for (int j = 0; j < ny; j++) {
+        int row = (cy + j) % rows;
+        for (int i = 0; i < nx; i++) {
+            int c = row * cols + (cx + i) % cols;
+            for (int e = cellStart[c]; e < cellStart[c + 1]; e++) {
+                tested++;
+                sweepTest(cellItems[e], from, delta, hx, hy, type, best, bestToi);
+            }
+        }
+    }
+    for (int p = 0; p < pendingCount; p++) {
+        tested++;
+        sweepTest(pending[p], from, delta, hx, hy, type, best, bestToi);
+    }
+    PROFILE_COUNT(PROFILE_QUERIES, 1);
+    PROFILE_COUNT(PROFILE_TESTED, tested);
+    if (best != -1) toi = bestToi;
+    return best;
+}
+
+void SpatialHash::pushNearest(int handle, const Point& p, float maxD2, int type, NearestQueue& queue, int& tested) const {
+    tested++;
+    if (!alive[handle]) return;
+    const GameObject& obj = items[handle];
+    if (type != -1 && obj.type != type) return;
+    float dx = obj.position.x - p.x, dy = obj.position.y - p.y;
+    float d2 = dx*dx + dy*dy;
+    if (d2 <= maxD2) queue.push(d2, handle);
+}
+
+int SpatialHash::nearest(const Point& p, int k, float maxRadius, int type, NearestQueue& queue,
+                         int* outHandles, float* outDist2) const {
+    if (k <= 0) return 0;
+    float maxD2 = maxRadius * maxRadius;
+    queue.clear();
+    int found = 0;
+    int tested = 0;
+
+    for (int i = 0; i < pendingCount; i++) pushNearest(pending[i], p, maxD2, type, queue, tested);
+
+    // Celda de 'p' (acotada al mundo) y anillos cada vez más anchos alrededor
+    int cx = (int)floorf((p.x - originX) / cellW);
+    int cy = (int)floorf((p.y - originY) / cellH);
+    if (cx < 0) cx = 0; else if (cx >= cols) cx = cols - 1;
+    if (cy < 0) cy = 0; else if (cy >= rows) cy = rows - 1;
+    float cell = cellW < cellH ? cellW : cellH;
+    int maxRing = cols > rows ? cols : rows;
+
+    for (int ring = 0; ring < maxRing && found < k; ring++) {
+        for (int y = cy - ring; y <= cy + ring; y++) {
+            if (y < 0 || y >= rows) continue;
+            bool edgeRow = (y == cy - ring || y == cy + ring);
+            for (int x = cx - ring; x <= cx + ring; x += edgeRow ? 1 : 2 * ring) {
+                if (x >= 0 && x < cols) {
+                    int c = y * cols + x;
+                    for (int e = cellStart[c]; e < cellStart[c + 1]; e++) pushNearest(cellItems[e], p, maxD2, type, queue, tested);
+                }
+                if (ring == 0) break;
+            }
+        }
+        // Lo que aún no se vio tiene el centro en el anillo siguiente o más lejos: a 'ring' celdas como mínimo.
+        // Los candidatos más cercanos que eso ya son definitivos; a la misma distancia aún puede
+        // aparecer un handle menor, así que esos esperan al anillo siguiente.
+        float bound = ring * cell;
+        bool last = ring + 1 == maxRing || bound * bound > maxD2;
+        while (found < k && !queue.empty() && (last || queue.minKey() < bound * bound)) {
+            float key;
+            int h;
+            queue.pop(key, h);
+            // Un objeto ocupa varias celdas: se descartan las repeticiones
+            bool repeated = false;
+            for (int j = 0; j < found && !repeated; j++) repeated = outHandles[j] == h;
+            if (repeated) continue;
+            outHandles[found] = h;
+            if (outDist2) outDist2[found] = key;
+            found++;
+        }
+        if (last) break;
+    }
+    PROFILE_COUNT(PROFILE_QUERIES, 1);
+    PROFILE_COUNT(PROFILE_TESTED, tested);
+    return found;
+}
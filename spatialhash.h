@@ -0,0 +1,71 @@
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include "broadphase.h"
+
+// Rejilla uniforme sobre un mundo toroidal: los objetos que cruzan un borde ocupan
+// también las celdas del lado opuesto y las consultas comparan distancias envueltas.
+// Las celdas se construyen por counting sort en dos arreglos planos (inicio por celda + handles).
+class SpatialHash : public Broadphase {
+private:
+    float originX, originY;
+    float worldW, worldH;
+    int cols, rows;
+    float cellW, cellH;
+
+    GameObject* items;
+    unsigned char* alive;
+    unsigned* stamps;
+    int handleCapacity;
+    int maxHandle;
+    unsigned stamp;
+    bool dirty;
+
+    int* cellStart;     // cols*rows + 1 entradas: inicio de cada celda en cellItems
+    int* cellCursor;
+    int* cellItems;
+    int entryCount, entryCapacity;
+    int* pending;       // altas desde la última reconstrucción, se prueban de forma lineal
+    int pendingCount, pendingCapacity;
+    int* scratch;
+    int scratchCount, scratchCapacity;
+    long long allocations;
+
+    template <typename T> void reserveArray(T*& data, int used, int newCap);
+    void reserveHandles(int handle);
+    void cellSpan(float lo, float size, float cell, int cells, int& first, int& count) const;
+    bool wrappedIntersects(const CustomRectangle& a, const CustomRectangle& b) const;
+    void consider(int handle, const CustomRectangle& range);
+    void sweepTest(int handle, const Point& from, const Point& delta, float hx, float hy, int type,
+                   int& best, float& bestToi) const;
+    void pushNearest(int handle, const Point& p, float maxD2, int type, NearestQueue& queue, int& tested) const;
+    void rebuild();
+
+    SpatialHash(const SpatialHash&) = delete;
+    SpatialHash& operator=(const SpatialHash&) = delete;
+public:
+    SpatialHash(float x, float y, float w, float h, float cellSize = 64.0f);
+    ~SpatialHash();
+    void insert(const GameObject& object, int handle) override;
+    void update(int handle, const CustomRectangle& newBounds) override;
+    void remove(int handle) override;
+    void clear() override;
+    void maintain() override;
+    HandleSpan queryHandles(const CustomRectangle& range) override;
+    // Recorre anillos de celdas alrededor de 'p' con distancia euclídea normal (sin envolver),
+    // la misma que usa el bot para apuntar
+    int nearest(const Point& p, int k, float maxRadius, int type, NearestQueue& queue,
+                int* outHandles, float* outDist2 = nullptr) const override;
+    int findFirst(const CustomRectangle& range, int type) const override;
+    // Prueba las celdas que cubren el trayecto (ampliado por la semiextensión); cada objeto se compara
+    // en su copia envuelta más cercana al punto de partida
+    int sweepFirst(const Point& from, const Point& to, float hx, float hy, int type, float& toi) const override;
+    const GameObject& get(int handle) const override { return items[handle]; }
+    const char* name() const override { return "grid"; }
+
+    int cellTotal() const { return cols * rows; }
+    int nodeTotal() const override { return cellTotal(); }
+    long long allocationCount() const override { return allocations; }
+};
+
+#endif
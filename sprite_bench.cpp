@@ -0,0 +1,115 @@
+// Benchmark de la limpieza de sprites (SuperCleanSprite) sin raylib.
+// Uso: sprite_bench [repeticiones] [hilos auxiliares]
+#include "spriteclean.h"
+#include "jobs.h"
+#include "rng.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static double nowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Imagen parecida a las reales: fondo oscuro o blanco, zonas brillantes y ruido
+static void fillSprite(unsigned char* rgba, int pixels, unsigned int seed) {
+    SimRng rng(seed);
+    for (int i = 0; i < pixels; i++) {
+        unsigned int v = rng.next();
+        int kind = (int)(v & 3);
+        unsigned char base = kind == 0 ? 250 : kind == 1 ? 20 : (unsigned char)(v >> 8);
+        rgba[i * 4 + 0] = (unsigned char)(base - ((v >> 16) & 7));
+        rgba[i * 4 + 1] = (unsigned char)(base - ((v >> 19) & 7));
+        rgba[i * 4 + 2] = (unsigned char)(base - ((v >> 22) & 7));
+        rgba[i * 4 + 3] = (unsigned char)(v >> 24);
+    }
+}
+
+// Todas las combinaciones de r, g, b (16,7 M píxeles) contra la versión escalar
+static bool exhaustiveCheck(bool isExplosion, JobSystem* jobs) {
+    const int pixels = 1 << 24;
+    unsigned char* ref = new unsigned char[(size_t)pixels * 4];
+    unsigned char* out = new unsigned char[(size_t)pixels * 4];
+    for (int i = 0; i < pixels; i++) {
+        ref[i * 4 + 0] = (unsigned char)i;
+        ref[i * 4 + 1] = (unsigned char)(i >> 8);
+        ref[i * 4 + 2] = (unsigned char)(i >> 16);
+        ref[i * 4 + 3] = (unsigned char)(i * 7 + 3);
+    }
+    memcpy(out, ref, (size_t)pixels * 4);
+    CleanSpritePixelsScalar(ref, pixels, isExplosion);
+    CleanSpritePixels(out, pixels, isExplosion, jobs);
+    bool same = memcmp(ref, out, (size_t)pixels * 4) == 0;
+    delete[] ref;
+    delete[] out;
+    return same;
+}
+
+// Devuelve false si alguna versión no coincide con la escalar
+static bool benchSize(int w, int h, bool isExplosion, int reps, JobSystem& jobs) {
+    int pixels = w * h;
+    size_t bytes = (size_t)pixels * 4;
+    unsigned char* source = new unsigned char[bytes];
+    unsigned char* ref = new unsigned char[bytes];
+    unsigned char* out = new unsigned char[bytes];
+    fillSprite(source, pixels, (unsigned int)(w * 31 + h));
+
+    // Cada repetición parte de la imagen original; solo se mide el kernel, no la copia
+    double tScalar = 0, tSimd = 0, tThreads = 0;
+    for (int r = 0; r < reps; r++) {
+        memcpy(ref, source, bytes);
+        double t0 = nowMs();
+        CleanSpritePixelsScalar(ref, pixels, isExplosion);
+        tScalar += nowMs() - t0;
+    }
+    bool sameSimd = true, sameThreads = true;
+    for (int r = 0; r < reps; r++) {
+        memcpy(out, source, bytes);
+        double t0 = nowMs();
+        CleanSpritePixels(out, pixels, isExplosion);
+        tSimd += nowMs() - t0;
+        sameSimd = sameSimd && memcmp(ref, out, bytes) == 0;
+    }
+    for (int r = 0; r < reps; r++) {
+        memcpy(out, source, bytes);
+        double t0 = nowMs();
+        CleanSpritePixels(out, pixels, isExplosion, &jobs);
+        tThreads += nowMs() - t0;
+        sameThreads = sameThreads && memcmp(ref, out, bytes) == 0;
+    }
+
+    printf("%5dx%-5d %-9s  escalar %8.3f ms  simd %8.3f ms (x%5.2f)  %d hilos %8.3f ms (x%5.2f)  %s\n",
+           w, h, isExplosion ? "explosion" : "sprite",
+           tScalar / reps, tSimd / reps, tScalar / tSimd,
+           jobs.threadCount(), tThreads / reps, tScalar / tThreads,
+           sameSimd && sameThreads ? "idéntico" : "DISTINTO");
+    delete[] source;
+    delete[] ref;
+    delete[] out;
+    return sameSimd && sameThreads;
+}
+
+int main(int argc, char** argv) {
+    int reps = argc > 1 ? atoi(argv[1]) : 20;
+    int workers = argc > 2 ? atoi(argv[2]) : JobSystem::defaultWorkers();
+    if (reps < 1) reps = 1;
+    JobSystem jobs(workers);
+
+    bool ok = true;
+    for (int mode = 0; mode < 2; mode++) {
+        bool same = exhaustiveCheck(mode == 1, &jobs);
+        printf("verificación exhaustiva %-9s %s\n", mode == 1 ? "explosion" : "sprite", same ? "idéntico" : "DISTINTO");
+        ok = ok && same;
+    }
+
+    // Tamaños de los recursos del juego (nave, asteroide, tira de explosión) y hojas de sprites grandes
+    const int sizes[][2] = { {128, 128}, {256, 256}, {1536, 256}, {1024, 1024}, {2048, 2048}, {4096, 4096} };
+    for (const int* s : sizes) {
+        ok = benchSize(s[0], s[1], false, reps, jobs) && ok;
+        ok = benchSize(s[0], s[1], true, reps, jobs) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include "spritebatch.h"
+#include "rlgl.h"
+
+#include <cmath>
+
+// Quads por rlBegin/rlEnd: cabe de sobra en el buffer por defecto de rlgl (también en GLES2/web)
+static const int SPRITE_CHUNK = 512;
+
+SpriteBatch::SpriteBatch()
+    : view({0, 0, 0, 0}), quads(nullptr), count(0), capacity(0), culled(0), drawn(0), allocations(0) {
+    texture.id = 0;
+    texture.width = texture.height = 1;
+}
+
+SpriteBatch::~SpriteBatch() {
+    delete[] quads;
+}
+
+void SpriteBatch::grow() {
+    int newCap = capacity > 0 ? capacity * 2 : 256;
+    Quad* newQuads = new Quad[newCap];
+    for (int i = 0; i < count; i++) newQuads[i] = quads[i];
+    delete[] quads;
+    quads = newQuads;
+    capacity = newCap;
+    allocations++;
+}
+
+void SpriteBatch::begin(Texture2D tex, Rectangle viewRect) {
+    texture = tex;
+    view = viewRect;
+    count = 0;
+    culled = 0;
+    drawn = 0;
+}
+
+void SpriteBatch::add(Rectangle src, Vector2 center, float width, float height, float rotation, Color tint) {
+    // Culling con el círculo que contiene el sprite girado
+    float radius = 0.5f * sqrtf(width * width + height * height);
+    if (center.x + radius < view.x || center.x - radius > view.x + view.width ||
+        center.y + radius < view.y || center.y - radius > view.y + view.height) {
+        culled++;
+        return;
+    }
+    if (count == capacity) grow();
+
+    Quad& q = quads[count++];
+    float hw = width * 0.5f, hh = height * 0.5f;
+    if (rotation == 0.0f) {
+        q.x[0] = q.x[1] = center.x - hw;
+        q.x[2] = q.x[3] = center.x + hw;
+        q.y[0] = q.y[3] = center.y - hh;
+        q.y[1] = q.y[2] = center.y + hh;
+    } else {
+        float s = sinf(rotation * DEG2RAD), c = cosf(rotation * DEG2RAD);
+        // Mismas esquinas que DrawTexturePro con el origen en el centro
+        const float dx[4] = { -hw, -hw, hw, hw };
+        const float dy[4] = { -hh, hh, hh, -hh };
+        for (int k = 0; k < 4; k++) {
+            q.x[k] = center.x + dx[k] * c - dy[k] * s;
+            q.y[k] = center.y + dx[k] * s + dy[k] * c;
+        }
+    }
+    q.u0 = src.x / texture.width;
+    q.v0 = src.y / texture.height;
+    q.u1 = (src.x + src.width) / texture.width;
+    q.v1 = (src.y + src.height) / texture.height;
+    q.tint = tint;
+}
+
+void SpriteBatch::flush() {
+    drawn = count;
+    if (count == 0) return;
+    rlSetTexture(texture.id);
+    for (int first = 0; first < count; first += SPRITE_CHUNK) {
+        int last = first + SPRITE_CHUNK < count ? first + SPRITE_CHUNK : count;
+        // Si no cabe en lo que queda del buffer de rlgl, lo pendiente se dibuja antes
+        rlCheckRenderBatchLimit(4 * (last - first));
+        rlBegin(RL_QUADS);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+        for (int i = first; i < last; i++) {
+            const Quad& q = quads[i];
+            rlColor4ub(q.tint.r, q.tint.g, q.tint.b, q.tint.a);
+            rlTexCoord2f(q.u0, q.v0); rlVertex2f(q.x[0], q.y[0]);
+            rlTexCoord2f(q.u0, q.v1); rlVertex2f(q.x[1], q.y[1]);
+            rlTexCoord2f(q.u1, q.v1); rlVertex2f(q.x[2], q.y[2]);
+            rlTexCoord2f(q.u1, q.v0); rlVertex2f(q.x[3], q.y[3]);
+        }
+        rlEnd();
+    }
+    rlSetTexture(0);
+    count = 0;
+}
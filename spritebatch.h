@@ -0,0 +1,47 @@
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include "raylib.h"
+
+// Lote de sprites de una sola textura: add() calcula las esquinas en un buffer de CPU que
+// se reutiliza entre frames y flush() lo envía a rlgl con un solo rlBegin/rlEnd, en vez de
+// un DrawTexturePro por sprite. Los sprites que caen fuera de la vista no llegan al buffer.
+class SpriteBatch {
+private:
+    struct Quad {
+        float x[4], y[4];       // arriba-izq, abajo-izq, abajo-der, arriba-der (orden de rlgl)
+        float u0, v0, u1, v1;
+        Color tint;
+    };
+
+    Texture2D texture;
+    Rectangle view;
+    Quad* quads;
+    int count;
+    int capacity;
+    int culled;
+    int drawn;
+    long long allocations;
+
+    void grow();
+
+    SpriteBatch(const SpriteBatch&) = delete;
+    SpriteBatch& operator=(const SpriteBatch&) = delete;
+public:
+    SpriteBatch();
+    ~SpriteBatch();
+
+    // Empieza un lote nuevo; lo que quede fuera de 'view' se descarta en add()
+    void begin(Texture2D tex, Rectangle viewRect);
+    // 'src' en píxeles de la textura; el sprite se centra en 'center' y gira 'rotation' grados
+    void add(Rectangle src, Vector2 center, float width, float height, float rotation, Color tint);
+    // Envía el lote (una llamada de dibujo mientras quepa en el buffer de rlgl) y lo vacía
+    void flush();
+
+    // Del último lote: sprites enviados y descartados por estar fuera de la vista
+    int drawnCount() const { return drawn; }
+    int culledCount() const { return culled; }
+    long long allocationCount() const { return allocations; }
+};
+
+#endif
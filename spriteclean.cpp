@@ -0,0 +1,158 @@
+#include "spriteclean.h"
+#include "jobs.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define SPRITECLEAN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SPRITECLEAN_SSE2 1
+#endif
+
+// Píxeles por trozo al repartir entre hilos: por debajo no compensa despertar a nadie
+static const int CLEAN_GRAIN = 64 * 1024;
+
+static const int EXPLOSION_CUTOFF = 35;
+
+struct Rgba8 { unsigned char r, g, b, a; };
+
+static inline void cleanExplosionPixel(Rgba8& p) {
+    int br = (p.r + p.g + p.b) / 3;
+
+    const int cutoff = EXPLOSION_CUTOFF;
+    const float gain = 3.0f;
+
+    int a = (int)((br - cutoff) * gain);
+    if (a < 0) a = 0;
+    if (a > 255) a = 255;
+
+    p.a = (unsigned char)a;
+    if (p.a == 0) p.r = p.g = p.b = 0;
+}
+
+static inline void cleanSpritePixel(Rgba8& p) {
+    if (p.r > 210 && p.g > 210 && p.b > 210) p.r = p.g = p.b = p.a = 0;
+}
+
+void CleanSpritePixelsScalar(unsigned char* rgba, int pixelCount, bool isExplosion) {
+    Rgba8* p = (Rgba8*)rgba;
+    for (int i = 0; i < pixelCount; i++) {
+        if (isExplosion) cleanExplosionPixel(p[i]);
+        else cleanSpritePixel(p[i]);
+    }
+}
+
+// Con enteros: (br - 35) * 3.0f es exacto en float, y para s <= 765, s / 3 == (s * 43691) >> 17.
+// El SIMD usa mulhi (>> 16) y luego >> 1.
+#if defined(SPRITECLEAN_AVX2)
+static inline __m256i explosionSum(__m256i px, __m256i byteMask) {
+    __m256i r = _mm256_and_si256(px, byteMask);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(px, 8), byteMask);
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(px, 16), byteMask);
+    return _mm256_add_epi32(_mm256_add_epi32(r, g), b);
+}
+
+static inline __m256i explosionApply(__m256i px, __m256i a) {
+    // a == 0 -> píxel entero a 0; si no, rgb intacto y alfa nuevo
+    __m256i rgb = _mm256_and_si256(px, _mm256_set1_epi32(0x00FFFFFF));
+    __m256i out = _mm256_or_si256(rgb, _mm256_slli_epi32(a, 24));
+    return _mm256_andnot_si256(_mm256_cmpeq_epi32(a, _mm256_setzero_si256()), out);
+}
+#elif defined(SPRITECLEAN_SSE2)
+static inline __m128i explosionSum(__m128i px, __m128i byteMask) {
+    __m128i r = _mm_and_si128(px, byteMask);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(px, 8), byteMask);
+    __m128i b = _mm_and_si128(_mm_srli_epi32(px, 16), byteMask);
+    return _mm_add_epi32(_mm_add_epi32(r, g), b);
+}
+
+static inline __m128i explosionApply(__m128i px, __m128i a) {
+    __m128i rgb = _mm_and_si128(px, _mm_set1_epi32(0x00FFFFFF));
+    __m128i out = _mm_or_si128(rgb, _mm_slli_epi32(a, 24));
+    return _mm_andnot_si128(_mm_cmpeq_epi32(a, _mm_setzero_si128()), out);
+}
+#endif
+
+static void cleanExplosion(unsigned char* rgba, int n) {
+    int i = 0;
+#if defined(SPRITECLEAN_AVX2)
+    __m256i byteMask = _mm256_set1_epi32(0xFF);
+    __m256i third = _mm256_set1_epi16((short)43691);
+    __m256i cutoff = _mm256_set1_epi16(EXPLOSION_CUTOFF);
+    __m256i three = _mm256_set1_epi16(3);
+    __m256i maxAlpha = _mm256_set1_epi16(255);
+    __m256i zero = _mm256_setzero_si256();
+    for (; i + 16 <= n; i += 16) {
+        __m256i p0 = _mm256_loadu_si256((const __m256i*)(rgba + i * 4));
+        __m256i p1 = _mm256_loadu_si256((const __m256i*)(rgba + i * 4 + 32));
+        // packs y unpack trabajan por mitades de 128 bits: el orden se recupera al deshacerlo
+        __m256i sum = _mm256_packs_epi32(explosionSum(p0, byteMask), explosionSum(p1, byteMask));
+        __m256i br = _mm256_srli_epi16(_mm256_mulhi_epu16(sum, third), 1);
+        __m256i a = _mm256_mullo_epi16(_mm256_sub_epi16(br, cutoff), three);
+        a = _mm256_min_epi16(_mm256_max_epi16(a, zero), maxAlpha);
+        _mm256_storeu_si256((__m256i*)(rgba + i * 4), explosionApply(p0, _mm256_unpacklo_epi16(a, zero)));
+        _mm256_storeu_si256((__m256i*)(rgba + i * 4 + 32), explosionApply(p1, _mm256_unpackhi_epi16(a, zero)));
+    }
+#elif defined(SPRITECLEAN_SSE2)
+    __m128i byteMask = _mm_set1_epi32(0xFF);
+    __m128i third = _mm_set1_epi16((short)43691);
+    __m128i cutoff = _mm_set1_epi16(EXPLOSION_CUTOFF);
+    __m128i three = _mm_set1_epi16(3);
+    __m128i maxAlpha = _mm_set1_epi16(255);
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        __m128i p0 = _mm_loadu_si128((const __m128i*)(rgba + i * 4));
+        __m128i p1 = _mm_loadu_si128((const __m128i*)(rgba + i * 4 + 16));
+        __m128i sum = _mm_packs_epi32(explosionSum(p0, byteMask), explosionSum(p1, byteMask));
+        __m128i br = _mm_srli_epi16(_mm_mulhi_epu16(sum, third), 1);
+        __m128i a = _mm_mullo_epi16(_mm_sub_epi16(br, cutoff), three);
+        a = _mm_min_epi16(_mm_max_epi16(a, zero), maxAlpha);
+        _mm_storeu_si128((__m128i*)(rgba + i * 4), explosionApply(p0, _mm_unpacklo_epi16(a, zero)));
+        _mm_storeu_si128((__m128i*)(rgba + i * 4 + 16), explosionApply(p1, _mm_unpackhi_epi16(a, zero)));
+    }
+#endif
+    Rgba8* p = (Rgba8*)rgba;
+    for (; i < n; i++) cleanExplosionPixel(p[i]);
+}
+
+static void cleanWhite(unsigned char* rgba, int n) {
+    int i = 0;
+    // x > 210 <=> max(x, 211) == x, byte a byte; el píxel se borra si r, g y b lo cumplen
+#if defined(SPRITECLEAN_AVX2)
+    __m256i limit = _mm256_set1_epi8((char)211);
+    __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+    for (; i + 8 <= n; i += 8) {
+        __m256i px = _mm256_loadu_si256((const __m256i*)(rgba + i * 4));
+        __m256i bright = _mm256_cmpeq_epi8(_mm256_max_epu8(px, limit), px);
+        __m256i white = _mm256_cmpeq_epi32(_mm256_and_si256(bright, rgbMask), rgbMask);
+        _mm256_storeu_si256((__m256i*)(rgba + i * 4), _mm256_andnot_si256(white, px));
+    }
+#elif defined(SPRITECLEAN_SSE2)
+    __m128i limit = _mm_set1_epi8((char)211);
+    __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    for (; i + 4 <= n; i += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i*)(rgba + i * 4));
+        __m128i bright = _mm_cmpeq_epi8(_mm_max_epu8(px, limit), px);
+        __m128i white = _mm_cmpeq_epi32(_mm_and_si128(bright, rgbMask), rgbMask);
+        _mm_storeu_si128((__m128i*)(rgba + i * 4), _mm_andnot_si128(white, px));
+    }
+#endif
+    Rgba8* p = (Rgba8*)rgba;
+    for (; i < n; i++) cleanSpritePixel(p[i]);
+}
+
+void CleanSpritePixels(unsigned char* rgba, int pixelCount, bool isExplosion) {
+    if (isExplosion) cleanExplosion(rgba, pixelCount);
+    else cleanWhite(rgba, pixelCount);
+}
+
+void CleanSpritePixels(unsigned char* rgba, int pixelCount, bool isExplosion, JobSystem* jobs) {
+    if (!jobs) {
+        CleanSpritePixels(rgba, pixelCount, isExplosion);
+        return;
+    }
+    // Cada píxel es independiente: los trozos no se pisan
+    jobs->parallelFor(pixelCount, CLEAN_GRAIN, [rgba, isExplosion](int begin, int end, int) {
+        CleanSpritePixels(rgba + (long long)begin * 4, end - begin, isExplosion);
+    });
+}
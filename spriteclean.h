@@ -0,0 +1,18 @@
+#ifndef SPRITECLEAN_H
+#define SPRITECLEAN_H
+
+class JobSystem;
+
+// Limpieza de sprites sobre píxeles RGBA8 (4 bytes por píxel, en el orden de raylib).
+//  - Explosión: alfa = clamp((media de r, g, b - 35) * 3, 0, 255); si queda en 0 el píxel pasa a negro transparente.
+//  - Resto: los píxeles casi blancos (r, g y b > 210) pasan a negro transparente.
+// Las versiones SIMD y por hilos dan exactamente los mismos bytes que la escalar.
+
+// Versión original píxel a píxel; sirve de referencia
+void CleanSpritePixelsScalar(unsigned char* rgba, int pixelCount, bool isExplosion);
+// SSE2/AVX2 con cola escalar
+void CleanSpritePixels(unsigned char* rgba, int pixelCount, bool isExplosion);
+// Igual, repartida en trozos entre los hilos de 'jobs' (nullptr = hilo actual)
+void CleanSpritePixels(unsigned char* rgba, int pixelCount, bool isExplosion, JobSystem* jobs);
+
+#endif